@@ -1,5 +1,6 @@
 #pragma once
 
+#include <charconv>
 #include <expected>
 #include <filesystem>
 #include <memory>
@@ -16,6 +17,19 @@ class Config {
     std::string get_or(const std::string& key, std::string_view default_value) const {
         return get(key).value_or(std::string(default_value));
     }
+    // std::nullopt if the key is missing, an error if the value is not a Number
+    template <typename Number>
+    std::expected<std::optional<Number>, std::string> get_number(const std::string& key) const {
+        const std::optional<std::string> value = get(key);
+        if (!value.has_value())
+            return std::nullopt;
+        Number number{};
+        const char* end = value->data() + value->size();
+        const auto [ptr, error] = std::from_chars(value->data(), end, number);
+        if (error != std::errc{} || ptr != end)
+            return std::unexpected("Invalid " + key + " value: " + *value);
+        return number;
+    }
     static std::expected<std::unique_ptr<Config>, std::string> create(std::filesystem::path path);
 
   protected:
@@ -32,6 +32,7 @@ class NodesLabels {
     size_t get_label(size_t node_id) const;
     void erase_label(size_t node_id);
     void update_label(size_t node_id, size_t new_label);
+    void update_size(size_t node_id);
 };
 
 class EdgesLabels {
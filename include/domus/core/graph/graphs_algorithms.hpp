@@ -32,8 +32,20 @@ class SpanningTree {
 
 std::optional<Cycle> find_an_undirected_cycle_in_graph(const Graph& graph);
 std::optional<Cycle> find_a_directed_cycle_in_graph(const Graph& graph);
+// a maximal set of directed cycles with no node in common, short ones first: in each strongly
+// connected component the shortest cycle (by breadth-first search) is taken, its nodes are
+// removed and so on
+std::vector<Cycle> find_short_disjoint_directed_cycles(const Graph& graph);
 
+// the fundamental cycles of SpanningTree::compute (a depth first tree, long cycles)
 std::vector<Cycle> compute_cycle_basis(const Graph& graph);
+// the fundamental cycles of a breadth first tree rooted at a center of the graph (a node of
+// minimum eccentricity), no longer than twice the radius plus one
+std::vector<Cycle> compute_breadth_first_cycle_basis(const Graph& graph);
+// Horton: the cycles made of an edge and the shortest paths from a node to its ends, by length,
+// each one kept if independent from the kept ones; a minimum weight cycle basis when the
+// shortest paths are unique, close to it otherwise
+std::vector<Cycle> compute_short_cycle_basis(const Graph& graph);
 
 std::optional<std::vector<size_t>> make_topological_ordering(const Graph& graph);
 
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <expected>
+#include <string>
+#include <vector>
+
 #include "domus/orthogonal/drawing.hpp"
+#include "domus/orthogonal/shape/shape_builder.hpp"
+#include "domus/sat/sat_backend.hpp"
 
 namespace domus::graph {
+class Cycle;
 class Graph;
-}
+} // namespace domus::graph
 
 namespace domus::orthogonal {
 
@@ -13,8 +20,22 @@ struct ShapeMetricsDrawing {
     size_t initial_number_of_cycles;
     size_t number_of_added_cycles;
     size_t number_of_useless_bends;
+    // summed over all the SAT calls of the drawing
+    sat::SatSolverStats sat_stats;
+    shape::SplitStats split_stats;
 };
 
-ShapeMetricsDrawing make_orthogonal_drawing(const graph::Graph& graph);
+// backend_type cannot be 2-sat, see the overload with the options
+ShapeMetricsDrawing make_orthogonal_drawing(
+    const graph::Graph& graph, sat::SatBackendType backend_type = sat::SatBackendType::GLUCOSE
+);
+
+// the graph must be connected
+std::vector<graph::Cycle> compute_cycle_basis(const graph::Graph& graph, shape::CycleBasis basis);
+
+// fails only if the SAT solver runs out of the budget of the options or the backend of the
+// options is 2-sat
+std::expected<ShapeMetricsDrawing, std::string>
+make_orthogonal_drawing(const graph::Graph& graph, const shape::ShapeBuilderOptions& options);
 
 } // namespace domus::orthogonal
\ No newline at end of file
@@ -12,13 +12,20 @@ namespace domus::orthogonal {
 using Shape = shape::Shape;
 using EdgesLabels = graph::utilities::EdgesLabels;
 
+class AxisOrdering;
+
 class EquivalenceClasses {
+    friend class AxisOrdering;
     graph::utilities::NodesLabels m_elem_to_class;
     std::vector<std::vector<size_t>> m_class_to_elems;
     size_t m_number_of_classes = 0;
+    // ids of the removed classes, reused by add_class
+    std::vector<size_t> m_free_class_ids;
     bool has_class(size_t class_id) const;
     void set_class(size_t elem, size_t class_id);
     size_t add_class();
+    // the elems of the class are left without a class, the class stays empty until reused
+    void remove_class(size_t class_id);
     EquivalenceClasses(const domus::graph::Graph& graph);
     void directional_node_expander(
         const Shape& shape,
@@ -37,6 +44,7 @@ class EquivalenceClasses {
     size_t get_class_of_elem(size_t elem) const;
     void for_each_elem_of_class(size_t class_id, std::function<void(size_t)> f) const;
     size_t number_of_elems_in_class(size_t class_id) const;
+    size_t get_number_of_classes() const;
 
     std::string to_string() const;
     void print() const;
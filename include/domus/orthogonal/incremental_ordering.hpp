@@ -0,0 +1,98 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+#include "domus/core/graph/graph_utilities.hpp"
+#include "domus/orthogonal/equivalence_classes.hpp"
+#include "domus/orthogonal/shape/shape.hpp"
+
+namespace domus::orthogonal {
+
+// the classes of one axis (nodes joined by vertical edges for x, by horizontal edges for y) and
+// the ordering graph among them, as built by EquivalenceClasses::build and Ordering::build but
+// kept up to date: a change rebuilds only the classes of the ends of the changed edges (all of
+// them if those classes hold most of the nodes).
+// a topological order of the ordering graph is maintained as its edges are added (Pearce-Kelly),
+// an edge that would close a cycle is set aside and tried again when some edge is removed, so
+// the ordering graph has a cycle exactly when some edge is set aside
+class AxisOrdering {
+    friend class IncrementalOrdering;
+    // the graph edges between the same two classes going the same way form a list, headed by
+    // the label of their ordering edge
+    struct GraphEdgeLink {
+        size_t ordering_edge_id;
+        std::optional<size_t> previous_edge_id;
+        std::optional<size_t> next_edge_id;
+    };
+    bool m_is_x;
+    EquivalenceClasses m_classes;
+    graph::Graph m_ordering;
+    EdgesLabels m_ordering_edge_to_graph_edge;
+    std::vector<bool> m_is_set_aside;
+    std::vector<size_t> m_set_aside_edges;
+    bool m_has_removed_edges = false;
+    // by graph edge
+    std::vector<std::optional<GraphEdgeLink>> m_graph_edge_links;
+    // by class and by position in the topological order
+    std::vector<size_t> m_position;
+    std::vector<size_t> m_class_at;
+    std::vector<bool> m_is_visited;
+
+    AxisOrdering(const graph::Graph& graph, bool is_x);
+    // from scratch, the order by a depth first search that sets aside its back edges
+    void rebuild(const graph::Graph& graph, const Shape& shape);
+    void update(
+        const graph::Graph& graph,
+        const Shape& shape,
+        std::span<const size_t> changed_edge_ids,
+        std::span<const size_t> touched_node_ids
+    );
+    void add_ordering_nodes();
+    void add_graph_edge(
+        const graph::Graph& graph, const Shape& shape, size_t edge_id, bool keep_order
+    );
+    void remove_graph_edge(size_t edge_id);
+    void insert_ordering_edge(size_t ordering_edge_id);
+    bool collect_forward(size_t class_id, size_t upper_position, std::vector<size_t>& classes);
+    void collect_backward(size_t class_id, size_t lower_position, std::vector<size_t>& classes);
+    void retry_set_aside_edges();
+    void compute_order();
+
+  public:
+    const EquivalenceClasses& get_classes() const;
+    // the nodes are the ids of the classes, the removed classes are left isolated
+    const graph::Graph& get_ordering() const;
+    const EdgesLabels& get_ordering_edge_to_graph_edge() const;
+    bool has_cycle() const;
+    // a cycle of the ordering graph through a set aside edge
+    std::optional<graph::Cycle> find_cycle() const;
+};
+
+// the classes and orderings of both axes for a graph and its shape, updated with the changes of
+// the shape and of the graph (nodes added, edges subdivided) instead of built again
+class IncrementalOrdering {
+    struct EdgeState {
+        graph::Edge edge;
+        std::optional<shape::Direction> direction;
+    };
+    // by graph edge, its ends and direction at the last update
+    std::vector<std::optional<EdgeState>> m_edges;
+    size_t m_number_of_nodes = 0;
+    AxisOrdering m_ordering_x;
+    AxisOrdering m_ordering_y;
+
+  public:
+    IncrementalOrdering(const graph::Graph& graph, const Shape& shape);
+    // finds the edges changed since the last update by comparing their ends and directions
+    void update(const graph::Graph& graph, const Shape& shape);
+    // only the given edges changed (were added, removed or got another direction)
+    void update(const graph::Graph& graph, const Shape& shape, std::span<const size_t> edge_ids);
+    const AxisOrdering& get_ordering_x() const;
+    const AxisOrdering& get_ordering_y() const;
+};
+
+} // namespace domus::orthogonal
\ No newline at end of file
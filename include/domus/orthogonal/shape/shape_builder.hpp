@@ -1,8 +1,22 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
 #include <vector>
 
 #include "domus/orthogonal/shape/shape.hpp"
+#include "domus/orthogonal/shape/solver_selection.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+namespace domus {
+class Config;
+}
 
 namespace domus::graph {
 class Cycle;
@@ -12,10 +26,121 @@ class Graph;
 
 namespace domus::orthogonal::shape {
 
-Shape build_shape(
-    graph::Graph& graph,
-    graph::Attributes& attributes,
-    std::vector<graph::Cycle>& cycles,
-    bool randomize = false
-);
+// what ShapeBuilder::build_shape does when a SAT call runs out of budget
+enum class BudgetPolicy {
+    FAIL, // build_shape returns an error
+    SOLVE_WITHOUT_BUDGET, // the rest of the build_shape call has no limits
+    ADD_CORNER, // a random edge gets a bend and the call goes on, fails once the time is over
+};
+
+// the cycles encoded before the first SAT call of make_orthogonal_drawing, every cycle takes
+// four clauses as long as the cycle
+enum class CycleBasis {
+    SPANNING_TREE, // fundamental cycles of a depth first tree
+    BREADTH_FIRST_TREE, // fundamental cycles of a breadth first tree rooted at a center
+    SHORT_CYCLES, // Horton's short cycles, a minimum weight basis up to ties
+};
+
+std::string cycle_basis_to_string(CycleBasis basis);
+
+std::expected<CycleBasis, std::string> string_to_cycle_basis(const std::string& basis);
+
+struct ShapeBuilderOptions {
+    bool randomize = false;
+    sat::SatBackendType backend_type = sat::SatBackendType::GLUCOSE;
+    sat::SatBackendOptions backend_options;
+    // picks the backend and its options from the features of the formula of every
+    // build_shape call, backend_type and backend_options apply when no rule does
+    std::optional<SolverRules> solver_rules;
+    // a shape rotated by 90 degrees or mirrored is still a shape, with break_symmetries the
+    // formula only admits one of the (up to eight) symmetric copies
+    bool break_symmetries = false;
+    // workers of the glucose-parallel and cube-and-conquer backends, one per hardware
+    // thread if 0
+    size_t sat_threads = 0;
+    // the conflict and propagation limits hold for each SAT call,
+    // the time limit for all the calls of a ShapeBuilder (from its construction)
+    std::optional<uint64_t> conflict_limit;
+    std::optional<uint64_t> propagation_limit;
+    std::optional<std::chrono::milliseconds> time_limit;
+    BudgetPolicy budget_policy = BudgetPolicy::FAIL;
+    // edges subdivided after each refutation of the SAT loop: besides the usual one, the
+    // edges of the core most shared by its constraints such that no two of them are in the
+    // same constraint or share a node; larger batches need fewer SAT calls but can add bends
+    // that a single split would avoid
+    size_t split_batch_size = 1;
+    // changes of direction of the local search tried by build_shape before the SAT solver,
+    // starting from the previous shape; 0 disables it
+    size_t local_search_flips = 0;
+    // make_orthogonal_drawing starts without cycle constraints instead of a cycle basis and
+    // adds only the cycles that the shapes of its loop get wrong
+    bool lazy_cycles = false;
+    CycleBasis cycle_basis = CycleBasis::SPANNING_TREE;
+    // debug mode: the formula of every SAT call is written there in DIMACS format,
+    // see domus-cnf-bench
+    std::optional<std::filesystem::path> cnf_dump_directory;
+};
+
+// reads the keys "sat_backend" (with the keys of get_sat_backend_options), "sat_rules"
+// (the path of a file read by SolverRules::create), "sat_threads", "symmetry_breaking"
+// ("true" or "false"), "sat_conflict_limit", "sat_propagation_limit", "sat_time_limit_ms",
+// "sat_budget_policy" ("fail", "solve_without_budget" or "add_corner"), "split_batch_size"
+// (at least 1), "local_search_flips", "lazy_cycles" ("true" or "false"), "cycle_basis"
+// ("spanning_tree", "breadth_first_tree" or "short_cycles") and "cnf_dump_dir";
+// the backend 2-sat is rejected, also in the rules
+std::expected<ShapeBuilderOptions, std::string> get_shape_builder_options(const Config& config);
+
+// the refutations of the SAT loops of a ShapeBuilder and the edges subdivided after them,
+// to weigh the SAT calls saved by split_batch_size against the bends it adds
+struct SplitStats {
+    size_t number_of_rounds = 0;
+    size_t number_of_split_edges = 0;
+    std::string to_string() const;
+};
+
+class ShapeSession;
+class CnfDumper;
+
+// reuses a single incremental SAT session across calls of build_shape:
+// between calls the graph must not be changed and cycles can only be appended;
+// with solver_rules the session starts over (keeping the previous shape as warm start)
+// when the formula moves to a rule with another configuration
+class ShapeBuilder {
+    std::unique_ptr<ShapeSession> m_session;
+    // the configuration of the solver of the session
+    SolverConfiguration m_configuration;
+    std::mt19937 m_random_engine;
+    ShapeBuilderOptions m_options;
+    sat::SatSolverBudget m_budget;
+    sat::SatSolverStats m_sat_stats;
+    SplitStats m_split_stats;
+    size_t m_number_of_calls = 0;
+    std::unique_ptr<CnfDumper> m_cnf_dumper;
+    // owned by the session, only with cnf_dump_directory
+    sat::RecordingBackend* m_recorder = nullptr;
+    SolverConfiguration select_configuration(
+        const graph::Graph& graph,
+        const graph::Attributes& attributes,
+        const std::vector<graph::Cycle>& cycles
+    ) const;
+    std::expected<void, std::string>
+    create_session(const graph::Graph& graph, const SolverConfiguration& configuration);
+
+  public:
+    explicit ShapeBuilder(const ShapeBuilderOptions& options = {});
+    ~ShapeBuilder();
+    ShapeBuilder(ShapeBuilder&&) noexcept;
+    ShapeBuilder& operator=(ShapeBuilder&&) noexcept;
+
+    // an error if the SAT solver ran out of budget (see BudgetPolicy), if the backend is
+    // 2-sat, which cannot solve the shape formulas, or if it cannot be created
+    std::expected<Shape, std::string> build_shape(
+        graph::Graph& graph, graph::Attributes& attributes, std::vector<graph::Cycle>& cycles
+    );
+
+    const sat::SatSolverStats& get_sat_stats() const { return m_sat_stats; }
+
+    const SplitStats& get_split_stats() const { return m_split_stats; }
+};
+
 } // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <expected>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "domus/sat/sat_backend.hpp"
+
+namespace domus {
+class Config;
+}
+
+namespace domus::graph {
+class Attributes;
+class Cycle;
+class Graph;
+} // namespace domus::graph
+
+namespace domus::orthogonal::shape {
+
+// size and structure of the shape formula of a graph, the input of the solver selection
+struct ShapeFormulaFeatures {
+    size_t number_of_variables = 0;
+    size_t number_of_clauses = 0;
+    // clauses with 1, 2, 3 and at least 4 literals
+    std::array<size_t, 4> clause_length_histogram{};
+    size_t number_of_cycles = 0;
+    size_t max_degree = 0;
+    // nodes added by the bends (colored red) over all the nodes
+    double subdivision_fraction = 0.0;
+
+    // by the names used in the rules: "variables", "clauses", "unit_clauses",
+    // "binary_clauses", "ternary_clauses", "long_clauses", "cycles", "max_degree",
+    // "subdivision_fraction"; std::nullopt for an unknown name
+    std::optional<double> get(std::string_view name) const;
+    std::string to_string() const;
+};
+
+// encodes the formula (without guards and symmetry breaking) to measure it
+ShapeFormulaFeatures compute_shape_formula_features(
+    const graph::Graph& graph,
+    const graph::Attributes& attributes,
+    const std::vector<graph::Cycle>& cycles
+);
+
+struct SolverConfiguration {
+    sat::SatBackendType backend_type = sat::SatBackendType::GLUCOSE;
+    sat::SatBackendOptions backend_options;
+    bool operator==(const SolverConfiguration& other) const = default;
+    std::string to_string() const;
+};
+
+// a comparison of a feature with a constant, as in "max_degree<=4"
+struct FeatureCondition {
+    std::string feature;
+    std::string comparison; // one of "<", "<=", ">", ">=", "=="
+    double value;
+    bool holds(const ShapeFormulaFeatures& features) const;
+    std::string to_string() const;
+};
+
+struct SolverRule {
+    // all of them must hold, a rule without conditions always applies
+    std::vector<FeatureCondition> conditions;
+    SolverConfiguration configuration;
+};
+
+// an ordered table of rules, the first one whose conditions hold gives the configuration
+class SolverRules {
+    std::vector<SolverRule> m_rules;
+
+  public:
+    explicit SolverRules(std::vector<SolverRule> rules) : m_rules(std::move(rules)) {}
+    // reads the key "rules" (the number of rules) and for each rule i the key "rule_<i>_when"
+    // (conditions separated by spaces) and the keys of get_sat_backend_type and
+    // get_sat_backend_options preceded by "rule_<i>_"
+    static std::expected<SolverRules, std::string> create(const Config& config);
+    // std::nullopt if no rule applies
+    std::optional<SolverConfiguration> select(const ShapeFormulaFeatures& features) const;
+    const std::vector<SolverRule>& get_rules() const { return m_rules; }
+    // the lines "key=value" that create reads back
+    std::string to_config() const;
+};
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
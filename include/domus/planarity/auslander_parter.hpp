@@ -10,4 +10,4 @@ class Graph;
 
 namespace domus::planarity {
 std::optional<Embedding> compute_planar_embedding(const graph::Graph& graph);
-}
\ No newline at end of file
+} // namespace domus::planarity
\ No newline at end of file
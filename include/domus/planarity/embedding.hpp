@@ -30,7 +30,7 @@ class Embedding {
     void print() const;
 };
 
-// TODO
+// the closed walks around the faces, along both sides of the bridges
 std::vector<graph::Path> compute_faces_in_embedding(const Embedding& embedding);
 
 size_t compute_number_of_faces_in_embedding(const Embedding& embedding);
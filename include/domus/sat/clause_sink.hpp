@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+namespace domus::sat {
+
+// destination of encoded clauses: a solver, a Cnf or a counter; reserve_variables tells
+// the sink that the variables up to number_of_variables are about to be used
+template <typename Sink>
+concept ClauseSink = requires(Sink& sink, std::span<const int> clause, size_t variables) {
+    sink.add_clause(clause);
+    sink.reserve_variables(variables);
+};
+
+template <ClauseSink Sink> void add_clause(Sink& sink, std::initializer_list<int> clause) {
+    sink.add_clause(std::span<const int>(clause.begin(), clause.size()));
+}
+
+// keeps only the size of the formula
+struct CountingSink {
+    size_t number_of_variables = 0;
+    size_t number_of_clauses = 0;
+    size_t number_of_literals = 0;
+
+    void add_clause(std::span<const int> clause) {
+        for (int lit : clause)
+            number_of_variables = std::max(number_of_variables, static_cast<size_t>(std::abs(lit)));
+        number_of_literals += clause.size();
+        number_of_clauses++;
+    }
+
+    void reserve_variables(size_t variables) {
+        number_of_variables = std::max(number_of_variables, variables);
+    }
+};
+
+// every clause gets the negation of the activation literal,
+// the clauses hold only when the activation is assumed
+template <ClauseSink Sink> class GuardedSink {
+    Sink& m_sink;
+    int m_activation;
+    std::vector<int> m_clause;
+
+  public:
+    GuardedSink(Sink& sink, int activation) : m_sink(sink), m_activation(activation) {}
+
+    void add_clause(std::span<const int> clause) {
+        m_clause.assign(clause.begin(), clause.end());
+        m_clause.push_back(-m_activation);
+        m_sink.add_clause(m_clause);
+    }
+
+    void reserve_variables(size_t variables) { m_sink.reserve_variables(variables); }
+};
+
+} // namespace domus::sat
\ No newline at end of file
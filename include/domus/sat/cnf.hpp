@@ -1,35 +1,47 @@
 #pragma once
 
 #include <expected>
+#include <initializer_list>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace domus::sat::cnf {
 
-enum class CnfRowType {
-    CLAUSE,
-    COMMENT,
-};
-
-struct CnfRow {
-    CnfRowType type;
-    std::vector<int> clause;
-    std::string comment;
-};
-
 class Cnf {
     size_t m_num_vars = 0;
-    size_t m_num_clauses = 0;
-    std::vector<CnfRow> m_rows;
+    // literals of all the clauses, clause i is [m_clause_offsets[i], m_clause_offsets[i + 1])
+    std::vector<int> m_literals;
+    std::vector<size_t> m_clause_offsets{0};
+    // each comment is printed before the clause with the given index
+    std::vector<std::pair<size_t, std::string>> m_comments;
 
   public:
-    void add_clause(std::vector<int> clause);
+    void add_clause(std::span<const int> clause);
+    void add_clause(std::initializer_list<int> clause);
     void add_comment(const std::string& comment);
+    // the formula declares at least number_of_variables variables, even if unused
+    void reserve_variables(size_t number_of_variables);
     size_t get_number_of_variables() const;
     size_t get_number_of_clauses() const;
+    size_t get_number_of_literals() const;
+    std::span<const int> get_clause(size_t clause_index) const;
+    // view of all the clauses, as spans inside the literals storage
+    auto get_clauses() const {
+        return std::views::iota(size_t{0}, get_number_of_clauses()) |
+               std::views::transform([this](size_t i) { return get_clause(i); });
+    }
+    // comments with the index of the clause they precede
+    const std::vector<std::pair<size_t, std::string>>& get_comments() const;
+    // writes the formula in DIMACS format
     std::expected<void, std::string> save_to_file(const std::string& file_path) const;
+    // reads a formula in DIMACS format, comments included; the header is optional and only
+    // used to reserve the variables
+    static std::expected<Cnf, std::string> parse_dimacs(std::string_view text);
     std::string to_string() const;
-    const std::vector<CnfRow>& get_rows() const;
     void print() const;
 };
 
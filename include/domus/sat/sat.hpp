@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <expected>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -9,20 +12,70 @@ namespace cnf {
 class Cnf;
 }
 
-enum class SatSolverResultType { SAT, UNSAT };
+// UNKNOWN only if the solve ran out of its budget or the solver cannot handle the formula
+enum class SatSolverResultType { SAT, UNSAT, UNKNOWN };
+
+std::string sat_solver_result_type_to_string(SatSolverResultType type);
+
+// limits of a single solve, a missing limit is not enforced; the deadline is checked
+// asynchronously, so the solver may go slightly past it
+// kissat has no propagation limit, ipasir and 2-sat only honor the deadline
+struct SatSolverBudget {
+    std::optional<uint64_t> conflicts;
+    std::optional<uint64_t> propagations;
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+    bool is_expired() const;
+};
+
+// counters of the solver during one solve, or the sum over many solves;
+// the counters that a solver does not expose are left to 0
+struct SatSolverStats {
+    size_t number_of_solves = 0;
+    uint64_t conflicts = 0;
+    uint64_t decisions = 0;
+    uint64_t propagations = 0;
+    uint64_t restarts = 0;
+    uint64_t learned_clauses = 0;
+    // peak resident memory of the whole process, the maximum over the solves
+    double peak_memory_mb = 0.0;
+    double wall_time_ms = 0.0;
+    SatSolverStats& operator+=(const SatSolverStats& other);
+    std::string to_string() const;
+    void print() const;
+};
 
 struct SatSolverResult {
     SatSolverResultType result;
     std::vector<int> numbers;
-    std::vector<std::string> proof_lines;
+    // last unit clauses added by the DRAT proof, most recent first
+    std::vector<int> proof_unit_clauses;
+    std::vector<int> failed_assumptions;
+    SatSolverStats stats;
     std::string to_string() const;
     void print() const;
 };
 
+// UNKNOWN if a clause has more than 2 literals
 SatSolverResult solve_2_sat(const cnf::Cnf& cnf);
 
-SatSolverResult launch_glucose(const cnf::Cnf& cnf);
+SatSolverResult launch_glucose(const cnf::Cnf& cnf, const SatSolverBudget& budget = {});
+
+// core mode: no proof is logged, if UNSAT failed_assumptions contains the assumptions
+// used in the refutation (empty if the formula is UNSAT without assumptions)
+SatSolverResult launch_glucose(
+    const cnf::Cnf& cnf, const std::vector<int>& assumptions, const SatSolverBudget& budget = {}
+);
+
+std::expected<SatSolverResult, std::string>
+launch_kissat(const cnf::Cnf& cnf, const SatSolverBudget& budget = {});
 
-std::expected<SatSolverResult, std::string> launch_kissat(const cnf::Cnf& cnf);
+// races glucose and kissat (one thread per kissat configuration) on the same formula,
+// the result of the first solver to finish is returned and the others are interrupted;
+// UNKNOWN if every solver ran out of the budget
+std::expected<SatSolverResult, std::string> launch_portfolio(
+    const cnf::Cnf& cnf,
+    const std::vector<std::string>& kissat_configurations = {"default"},
+    const SatSolverBudget& budget = {}
+);
 
 } // namespace domus::sat
\ No newline at end of file
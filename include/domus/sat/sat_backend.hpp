@@ -0,0 +1,130 @@
+#pragma once
+
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "domus/sat/cnf.hpp"
+#include "domus/sat/sat.hpp"
+
+namespace domus {
+class Config;
+}
+
+namespace domus::sat {
+
+// IPASIR is the solver library linked with the DOMUS_WITH_IPASIR cmake option
+enum class SatBackendType {
+    GLUCOSE,
+    GLUCOSE_PARALLEL,
+    KISSAT,
+    PORTFOLIO,
+    CUBE_AND_CONQUER,
+    TWO_SAT,
+    IPASIR
+};
+
+std::string sat_backend_type_to_string(SatBackendType type);
+
+std::expected<SatBackendType, std::string> string_to_sat_backend_type(const std::string& type);
+
+// reads the key prefix + "sat_backend", glucose if the key is missing
+std::expected<SatBackendType, std::string>
+get_sat_backend_type(const Config& config, const std::string& prefix = "");
+
+// tunables of the backends, a missing value keeps the default of the solver
+struct SatBackendOptions {
+    // the glucose based backends (all but kissat, 2-sat and ipasir): the constants that force
+    // (K) and block (R) restarts and the sizes of the lbd and trail queues they are compared
+    // with
+    std::optional<double> glucose_k;
+    std::optional<double> glucose_r;
+    std::optional<int> glucose_lbd_queue_size;
+    std::optional<int> glucose_trail_queue_size;
+    // kissat and portfolio: a configuration of kissat ("default", "basic", "plain", "sat",
+    // "unsat")
+    std::string kissat_configuration = "default";
+    bool operator==(const SatBackendOptions& other) const = default;
+    std::string to_string() const;
+};
+
+// reads the keys "glucose_k", "glucose_r", "glucose_lbd_queue_size",
+// "glucose_trail_queue_size" and "kissat_configuration", each preceded by prefix;
+// kissat has no failed assumptions, so after an UNSAT solve it shrinks the core with up to
+// 16 more solves from scratch, within the conflicts and the deadline left by the first one:
+// an UNSAT call can take as long as its whole budget and return a core that is not minimal
+std::expected<SatBackendOptions, std::string>
+get_sat_backend_options(const Config& config, const std::string& prefix = "");
+
+// the lines "key=value" that get_sat_backend_options reads back, missing and default values
+// are omitted
+std::string
+sat_backend_options_to_config(const SatBackendOptions& options, const std::string& prefix = "");
+
+struct SatBackendStats {
+    size_t number_of_variables = 0;
+    size_t number_of_clauses = 0;
+    size_t number_of_solves = 0;
+};
+
+// clauses persist across calls to solve, assumptions only hold for the call they are
+// passed to; the result contains the model if SAT and the core (failed assumptions) if UNSAT
+class SatBackend {
+    SatSolverBudget m_budget;
+
+  public:
+    virtual ~SatBackend() = default;
+    virtual void add_clause(std::span<const int> clause) = 0;
+    virtual void reserve_variables(size_t number_of_variables) = 0;
+    virtual SatSolverResult solve(const std::vector<int>& assumptions) = 0;
+    // preferred values of the variables (the literals to try first) for the next solves,
+    // only a hint: 2-sat and ipasir ignore it
+    virtual void set_phases(std::span<const int> literals) = 0;
+    // the conjunctions of literals that the next solves split the search into, they must
+    // cover every assignment; only a hint: only cube-and-conquer uses it
+    virtual void set_cubes(const std::vector<std::vector<int>>& /*cubes*/) {}
+    virtual SatBackendStats get_stats() const = 0;
+    // limits of each of the next calls to solve, which return UNKNOWN when out of budget
+    void set_budget(const SatSolverBudget& budget) { m_budget = budget; }
+    const SatSolverBudget& get_budget() const { return m_budget; }
+    // glucose is incremental and returns the assumptions used in the refutation,
+    // glucose-parallel does the same with number_of_threads clause-sharing workers
+    // (one per hardware thread if 0), kissat solves from scratch every time and shrinks
+    // the core with extra solves, portfolio races glucose and kissat on every solve and
+    // returns the core of glucose, cube-and-conquer solves the cubes of set_cubes with
+    // number_of_threads glucose workers and combines their cores, 2-sat only accepts clauses
+    // with one or two literals (any other clause makes its solves UNKNOWN) and returns all
+    // the assumptions; 2-sat and ipasir ignore the options; an error for ipasir without
+    // DOMUS_WITH_IPASIR and for an unknown kissat configuration (kissat and portfolio)
+    static std::expected<std::unique_ptr<SatBackend>, std::string> create(
+        SatBackendType type, size_t number_of_threads = 0, const SatBackendOptions& options = {}
+    );
+
+  protected:
+    SatBackend() = default;
+};
+
+// forwards everything to another backend and keeps a copy of the formula it receives,
+// so that the formulas of a run can be dumped and replayed offline
+class RecordingBackend final : public SatBackend {
+    std::unique_ptr<SatBackend> m_backend;
+    cnf::Cnf m_formula;
+    std::vector<int> m_last_assumptions;
+
+  public:
+    explicit RecordingBackend(std::unique_ptr<SatBackend> backend);
+    void add_clause(std::span<const int> clause) override;
+    void reserve_variables(size_t number_of_variables) override;
+    SatSolverResult solve(const std::vector<int>& assumptions) override;
+    void set_phases(std::span<const int> literals) override;
+    void set_cubes(const std::vector<std::vector<int>>& cubes) override;
+    SatBackendStats get_stats() const override;
+    // all the clauses added so far
+    const cnf::Cnf& get_formula() const { return m_formula; }
+    const std::vector<int>& get_last_assumptions() const { return m_last_assumptions; }
+};
+
+} // namespace domus::sat
\ No newline at end of file
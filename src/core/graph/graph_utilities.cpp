@@ -56,6 +56,11 @@ void NodesLabels::update_label(size_t node_id, size_t new_label) {
     m_labels[node_id] = new_label;
 }
 
+void NodesLabels::update_size(size_t node_id) {
+    while (m_labels.size() <= node_id)
+        m_labels.push_back(std::nullopt);
+}
+
 EdgesLabels::EdgesLabels(const Graph& graph) { m_labels.resize(graph.get_number_of_edges()); }
 
 EdgesLabels::EdgesLabels(size_t number_of_edges) { m_labels.resize(number_of_edges); }
@@ -1,6 +1,8 @@
 #include "domus/core/graph/graphs_algorithms.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <functional>
 #include <optional>
 #include <print>
@@ -114,6 +116,79 @@ std::optional<Cycle> find_a_directed_cycle_in_graph(const Graph& graph) {
     return cycle;
 }
 
+// the shortest directed cycle through start among the allowed nodes, breadth-first on the
+// out edges; std::nullopt if there is none
+std::optional<Cycle> find_shortest_directed_cycle_through(
+    const Graph& graph, size_t start, const std::vector<bool>& is_allowed
+) {
+    std::vector<std::optional<size_t>> parent_edge(graph.get_number_of_nodes());
+    std::vector<bool> is_visited(graph.get_number_of_nodes(), false);
+    std::queue<size_t> queue;
+    queue.push(start);
+    is_visited[start] = true;
+    while (!queue.empty()) {
+        const size_t node_id = queue.front();
+        queue.pop();
+        for (const auto [edge_id, neighbor_id] : graph.get_out_edges(node_id)) {
+            if (neighbor_id == start) {
+                std::vector<size_t> edges{edge_id};
+                for (size_t current = node_id; current != start;) {
+                    edges.push_back(*parent_edge[current]);
+                    current = graph.get_edge(*parent_edge[current]).from_id;
+                }
+                Path path;
+                size_t prev_id = start;
+                for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+                    path.push_back(graph, prev_id, *it);
+                    prev_id = graph.get_edge(*it).to_id;
+                }
+                return Cycle(path);
+            }
+            if (!is_allowed[neighbor_id] || is_visited[neighbor_id])
+                continue;
+            is_visited[neighbor_id] = true;
+            parent_edge[neighbor_id] = edge_id;
+            queue.push(neighbor_id);
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<Cycle> find_short_disjoint_directed_cycles(const Graph& graph) {
+    const StrongConnectedComponents components = StrongConnectedComponents::compute(graph);
+    std::vector<Cycle> cycles;
+    std::vector<bool> is_allowed(graph.get_number_of_nodes(), false);
+    for (const std::vector<size_t>& scc : components.sccs) {
+        if (scc.size() < 2)
+            continue;
+        for (size_t node_id : scc)
+            is_allowed[node_id] = true;
+        // greedily the shortest cycle left in the component, then without its nodes
+        while (true) {
+            std::optional<Cycle> shortest;
+            for (size_t node_id : scc) {
+                if (!is_allowed[node_id])
+                    continue;
+                std::optional<Cycle> cycle =
+                    find_shortest_directed_cycle_through(graph, node_id, is_allowed);
+                if (cycle.has_value() &&
+                    (!shortest.has_value() || cycle->size() < shortest->size()))
+                    shortest = std::move(cycle);
+                if (shortest.has_value() && shortest->size() == 2)
+                    break;
+            }
+            if (!shortest.has_value())
+                break;
+            for (size_t node_id : shortest->get_nodes_ids())
+                is_allowed[node_id] = false;
+            cycles.push_back(std::move(*shortest));
+        }
+        for (size_t node_id : scc)
+            is_allowed[node_id] = false;
+    }
+    return cycles;
+}
+
 std::vector<Cycle> compute_cycle_basis(const Graph& graph) {
     DOMUS_ASSERT(is_graph_connected(graph), "compute_cycle_basis: input graph is not connected");
 
@@ -151,6 +226,235 @@ std::vector<Cycle> compute_cycle_basis(const Graph& graph) {
     return cycles;
 }
 
+// the edge to the parent of each node reached from the root (the root has none) and the depths
+std::vector<size_t> compute_breadth_first_tree(
+    const Graph& graph, size_t root_id, NodesLabels& parent_edge_ids
+) {
+    std::vector<size_t> depths(graph.get_number_of_nodes(), SIZE_MAX);
+    std::queue<size_t> queue;
+    queue.push(root_id);
+    depths[root_id] = 0;
+    while (!queue.empty()) {
+        const size_t node_id = queue.front();
+        queue.pop();
+        for (auto [edge_id, neighbor_id] : graph.get_edges(node_id)) {
+            if (depths[neighbor_id] != SIZE_MAX)
+                continue;
+            depths[neighbor_id] = depths[node_id] + 1;
+            parent_edge_ids.add_label(neighbor_id, edge_id);
+            queue.push(neighbor_id);
+        }
+    }
+    return depths;
+}
+
+// the largest distance from the node, only its search is kept (in distances)
+size_t compute_eccentricity(const Graph& graph, size_t node_id, std::vector<size_t>& distances) {
+    distances.assign(graph.get_number_of_nodes(), SIZE_MAX);
+    std::queue<size_t> queue;
+    queue.push(node_id);
+    distances[node_id] = 0;
+    size_t eccentricity = 0;
+    while (!queue.empty()) {
+        const size_t current_id = queue.front();
+        queue.pop();
+        eccentricity = distances[current_id];
+        for (size_t neighbor_id : graph.get_neighbors(current_id)) {
+            if (distances[neighbor_id] != SIZE_MAX)
+                continue;
+            distances[neighbor_id] = distances[current_id] + 1;
+            queue.push(neighbor_id);
+        }
+    }
+    return eccentricity;
+}
+
+size_t get_parent_id(const Graph& graph, const NodesLabels& parent_edge_ids, size_t node_id) {
+    const auto [from_id, to_id] = graph.get_edge(parent_edge_ids.get_label(node_id));
+    return from_id == node_id ? to_id : from_id;
+}
+
+bool is_tree_edge(const NodesLabels& parent_edge_ids, size_t edge_id, size_t node_id) {
+    return parent_edge_ids.has_label(node_id) && parent_edge_ids.get_label(node_id) == edge_id;
+}
+
+// the ancestor of both nodes farthest from the root
+size_t find_common_ancestor(
+    const Graph& graph,
+    const NodesLabels& parent_edge_ids,
+    const std::vector<size_t>& depths,
+    size_t node_id_1,
+    size_t node_id_2
+) {
+    while (node_id_1 != node_id_2) {
+        if (depths[node_id_1] >= depths[node_id_2])
+            node_id_1 = get_parent_id(graph, parent_edge_ids, node_id_1);
+        else
+            node_id_2 = get_parent_id(graph, parent_edge_ids, node_id_2);
+    }
+    return node_id_1;
+}
+
+// the non tree edge followed by the path of the tree back to its first node
+Cycle build_fundamental_cycle(
+    const Graph& graph,
+    const NodesLabels& parent_edge_ids,
+    const std::vector<size_t>& depths,
+    size_t node_id,
+    size_t edge_id,
+    size_t neighbor_id
+) {
+    Path path;
+    path.push_back(graph, node_id, edge_id);
+    while (node_id != neighbor_id) {
+        if (depths[node_id] >= depths[neighbor_id]) {
+            path.push_front(graph, node_id, parent_edge_ids.get_label(node_id));
+            node_id = get_parent_id(graph, parent_edge_ids, node_id);
+        } else {
+            path.push_back(graph, neighbor_id, parent_edge_ids.get_label(neighbor_id));
+            neighbor_id = get_parent_id(graph, parent_edge_ids, neighbor_id);
+        }
+    }
+    return Cycle(path);
+}
+
+std::vector<Cycle> compute_breadth_first_cycle_basis(const Graph& graph) {
+    DOMUS_ASSERT(
+        is_graph_connected(graph),
+        "compute_breadth_first_cycle_basis: input graph is not connected"
+    );
+    std::vector<Cycle> cycles;
+    if (graph.get_number_of_nodes() == 0)
+        return cycles;
+    size_t center_id = 0;
+    size_t radius = SIZE_MAX;
+    std::vector<size_t> distances;
+    for (size_t node_id : graph.get_node_ids()) {
+        const size_t eccentricity = compute_eccentricity(graph, node_id, distances);
+        if (eccentricity < radius) {
+            radius = eccentricity;
+            center_id = node_id;
+        }
+    }
+    NodesLabels parent_edge_ids(graph);
+    const std::vector<size_t> depths =
+        compute_breadth_first_tree(graph, center_id, parent_edge_ids);
+    for (size_t node_id : graph.get_node_ids())
+        for (auto [edge_id, neighbor_id] : graph.get_out_edges(node_id)) {
+            if (is_tree_edge(parent_edge_ids, edge_id, node_id) ||
+                is_tree_edge(parent_edge_ids, edge_id, neighbor_id))
+                continue;
+            cycles.push_back(
+                build_fundamental_cycle(
+                    graph, parent_edge_ids, depths, node_id, edge_id, neighbor_id
+                )
+            );
+        }
+    return cycles;
+}
+
+// the edge sets of the added cycles over GF(2), in echelon form: each row has a pivot edge
+// that the rows after it do not have
+class IndependentCycles {
+    EdgesLabels m_edge_to_column;
+    size_t m_number_of_words;
+    std::vector<std::vector<uint64_t>> m_rows;
+    std::vector<size_t> m_pivots;
+
+  public:
+    explicit IndependentCycles(const Graph& graph) : m_edge_to_column(graph) {
+        size_t number_of_columns = 0;
+        for (size_t node_id : graph.get_node_ids())
+            for (auto [edge_id, neighbor_id] : graph.get_out_edges(node_id))
+                m_edge_to_column.add_label(edge_id, number_of_columns++);
+        m_number_of_words = (number_of_columns + 63) / 64;
+    }
+
+    // the cycle is added only if it is independent from the added ones
+    bool add(const Cycle& cycle) {
+        std::vector<uint64_t> row(m_number_of_words, 0);
+        for (size_t i = 0; i < cycle.size(); ++i) {
+            const size_t column = m_edge_to_column.get_label(cycle.edge_id_at(i));
+            row[column / 64] ^= uint64_t{1} << (column % 64);
+        }
+        for (size_t i = 0; i < m_rows.size(); ++i)
+            if (row[m_pivots[i] / 64] >> (m_pivots[i] % 64) & 1)
+                for (size_t word = 0; word < m_number_of_words; ++word)
+                    row[word] ^= m_rows[i][word];
+        const auto it = std::ranges::find_if(row, [](uint64_t word) { return word != 0; });
+        if (it == row.end())
+            return false;
+        const size_t word = static_cast<size_t>(it - row.begin());
+        m_pivots.push_back(word * 64 + static_cast<size_t>(std::countr_zero(*it)));
+        m_rows.push_back(std::move(row));
+        return true;
+    }
+
+    size_t size() const { return m_rows.size(); }
+};
+
+// the number of cycles in a basis of a connected graph
+size_t compute_cycle_rank(const Graph& graph) {
+    if (graph.get_number_of_nodes() == 0)
+        return 0;
+    return graph.get_number_of_edges() + 1 - graph.get_number_of_nodes();
+}
+
+std::vector<Cycle> compute_short_cycle_basis(const Graph& graph) {
+    DOMUS_ASSERT(
+        is_graph_connected(graph),
+        "compute_short_cycle_basis: input graph is not connected"
+    );
+    // a candidate is kept as its length, the root of its tree and its edge; only one tree is
+    // in memory at a time, the tree of a root is built again when its candidates come
+    struct Candidate {
+        size_t length;
+        size_t root_id;
+        size_t edge_id;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t root_id : graph.get_node_ids()) {
+        NodesLabels parent_edge_ids(graph);
+        const std::vector<size_t> depths =
+            compute_breadth_first_tree(graph, root_id, parent_edge_ids);
+        for (size_t node_id : graph.get_node_ids())
+            for (auto [edge_id, neighbor_id] : graph.get_out_edges(node_id)) {
+                if (is_tree_edge(parent_edge_ids, edge_id, node_id) ||
+                    is_tree_edge(parent_edge_ids, edge_id, neighbor_id))
+                    continue;
+                // otherwise the paths to the ends of the edge share their first edges
+                const size_t common_ancestor =
+                    find_common_ancestor(graph, parent_edge_ids, depths, node_id, neighbor_id);
+                if (common_ancestor != root_id)
+                    continue;
+                candidates.push_back({depths[node_id] + depths[neighbor_id] + 1, root_id, edge_id});
+            }
+    }
+    // the candidates of the same length stay grouped by root
+    std::ranges::stable_sort(candidates, {}, &Candidate::length);
+    const size_t cycle_rank = compute_cycle_rank(graph);
+    IndependentCycles independent_cycles(graph);
+    std::vector<Cycle> basis;
+    std::optional<size_t> tree_root_id;
+    NodesLabels parent_edge_ids(graph);
+    std::vector<size_t> depths;
+    for (const auto& [length, root_id, edge_id] : candidates) {
+        if (basis.size() == cycle_rank)
+            break;
+        if (tree_root_id != root_id) {
+            parent_edge_ids = NodesLabels(graph);
+            depths = compute_breadth_first_tree(graph, root_id, parent_edge_ids);
+            tree_root_id = root_id;
+        }
+        const auto [node_id, neighbor_id] = graph.get_edge(edge_id);
+        Cycle cycle =
+            build_fundamental_cycle(graph, parent_edge_ids, depths, node_id, edge_id, neighbor_id);
+        if (independent_cycles.add(cycle))
+            basis.push_back(std::move(cycle));
+    }
+    return basis;
+}
+
 std::optional<std::vector<size_t>> make_topological_ordering(const Graph& graph) {
     NodesLabels in_degree(graph);
     for (size_t node_id : graph.get_node_ids())
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "domus/core/graph/attributes.hpp"
+#include "domus/core/graph/file_loader.hpp"
+#include "domus/core/graph/generators.hpp"
+#include "domus/core/graph/graph.hpp"
+#include "domus/core/graph/graphs_algorithms.hpp"
+#include "domus/orthogonal/drawing_builder.hpp"
+#include "domus/orthogonal/drawing_stats.hpp"
+#include "domus/orthogonal/shape/shape_builder.hpp"
+#include "domus/orthogonal/shape/solver_selection.hpp"
+
+using namespace domus;
+using namespace domus::orthogonal;
+
+struct BenchmarkGraph {
+    std::string name;
+    graph::Graph graph;
+};
+
+std::vector<BenchmarkGraph> load_benchmark_graphs(const std::filesystem::path& directory) {
+    std::vector<BenchmarkGraph> graphs;
+    std::vector<std::filesystem::path> paths;
+    if (std::filesystem::is_directory(directory))
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+            if (entry.path().extension() == ".txt")
+                paths.push_back(entry.path());
+    std::ranges::sort(paths);
+    for (const auto& path : paths) {
+        auto graph = graph::loader::load_graph_from_txt_file(path.string());
+        if (!graph) {
+            std::println("skipping {}: {}", path.string(), graph.error());
+            continue;
+        }
+        graphs.push_back({path.filename().string(), std::move(*graph)});
+    }
+    for (const size_t size : {size_t{6}, size_t{10}, size_t{14}}) {
+        const std::string name = std::format("grid_{}x{}", size, size);
+        graphs.push_back({name, graph::generators::generate_grid_graph(size, size)});
+    }
+    return graphs;
+}
+
+// milliseconds and bends of the drawing
+std::pair<double, size_t>
+run(const graph::Graph& graph, const shape::ShapeBuilderOptions& options) {
+    const auto start = std::chrono::steady_clock::now();
+    // no budget is set, so the drawing cannot fail
+    const ShapeMetricsDrawing result = make_orthogonal_drawing(graph, options).value();
+    const auto end = std::chrono::steady_clock::now();
+    const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return {milliseconds, stats::compute_all_orthogonal_stats(result.drawing).bends};
+}
+
+// the features of the formula of the first SAT call of the drawing
+shape::ShapeFormulaFeatures get_initial_features(const graph::Graph& graph) {
+    graph::Attributes attributes;
+    attributes.add_attribute(graph::Attribute::NODES_COLOR);
+    graph.for_each_node([&](size_t node_id) { attributes.set_node_color(node_id, Color::BLACK); });
+    const std::vector<graph::Cycle> cycles = graph::algorithms::compute_cycle_basis(graph);
+    return shape::compute_shape_formula_features(graph, attributes, cycles);
+}
+
+std::vector<shape::SolverConfiguration> get_calibration_candidates() {
+    using sat::SatBackendType;
+    sat::SatBackendOptions fewer_restarts; // glucose forces a restart less often
+    fewer_restarts.glucose_k = 0.7;
+    sat::SatBackendOptions more_blocked_restarts;
+    more_blocked_restarts.glucose_r = 1.2;
+    sat::SatBackendOptions kissat_sat;
+    kissat_sat.kissat_configuration = "sat";
+    sat::SatBackendOptions kissat_unsat;
+    kissat_unsat.kissat_configuration = "unsat";
+    return {
+        {SatBackendType::GLUCOSE, {}},
+        {SatBackendType::GLUCOSE, fewer_restarts},
+        {SatBackendType::GLUCOSE, more_blocked_restarts},
+        {SatBackendType::KISSAT, {}},
+        {SatBackendType::KISSAT, kissat_sat},
+        {SatBackendType::KISSAT, kissat_unsat},
+    };
+}
+
+// the size of the formula times the presence of nodes of degree larger than 4
+std::vector<std::vector<shape::FeatureCondition>> get_calibration_buckets() {
+    const std::vector<std::vector<shape::FeatureCondition>> sizes = {
+        {{"variables", "<", 1000}},
+        {{"variables", ">=", 1000}, {"variables", "<", 10000}},
+        {{"variables", ">=", 10000}},
+    };
+    std::vector<std::vector<shape::FeatureCondition>> buckets;
+    for (const auto& size : sizes)
+        for (const std::string_view comparison : {"<=", ">"}) {
+            buckets.push_back(size);
+            buckets.back().push_back({"max_degree", std::string(comparison), 4});
+        }
+    return buckets;
+}
+
+std::string conditions_to_string(const std::vector<shape::FeatureCondition>& conditions) {
+    std::string text;
+    for (const shape::FeatureCondition& condition : conditions)
+        text += (text.empty() ? "" : " ") + condition.to_string();
+    return text;
+}
+
+// runs every candidate configuration on every graph and writes to output the rules that pick,
+// for each bucket of the features of the first formula, the fastest candidate in total
+int calibrate(const std::filesystem::path& output, const std::filesystem::path& directory) {
+    const std::vector<shape::SolverConfiguration> candidates = get_calibration_candidates();
+    const std::vector<std::vector<shape::FeatureCondition>> buckets = get_calibration_buckets();
+    std::vector<std::vector<double>> totals(buckets.size(), std::vector<double>(candidates.size()));
+    std::vector<size_t> number_of_graphs(buckets.size(), 0);
+    for (size_t i = 0; i < candidates.size(); ++i)
+        std::println("candidate {}: {}", i, candidates[i].to_string());
+    std::string header = std::format("{:<24} {:>10} {:>6}", "graph", "variables", "bucket");
+    for (size_t i = 0; i < candidates.size(); ++i)
+        header += std::format(" {:>12}", std::format("{} ms", i));
+    std::println("{}", header);
+    for (const auto& [name, graph] : load_benchmark_graphs(directory)) {
+        const shape::ShapeFormulaFeatures features = get_initial_features(graph);
+        size_t bucket = 0;
+        while (!std::ranges::all_of(buckets[bucket], [&](const shape::FeatureCondition& c) {
+            return c.holds(features);
+        }))
+            bucket++;
+        number_of_graphs[bucket]++;
+        std::string line =
+            std::format("{:<24} {:>10} {:>6}", name, features.number_of_variables, bucket);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            shape::ShapeBuilderOptions options;
+            options.backend_type = candidates[i].backend_type;
+            options.backend_options = candidates[i].backend_options;
+            const double milliseconds = run(graph, options).first;
+            totals[bucket][i] += milliseconds;
+            line += std::format(" {:>12.1f}", milliseconds);
+        }
+        std::println("{}", line);
+    }
+    std::vector<shape::SolverRule> rules;
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        if (number_of_graphs[bucket] == 0)
+            continue;
+        const size_t best = static_cast<size_t>(
+            std::ranges::min_element(totals[bucket]) - totals[bucket].begin()
+        );
+        std::println(
+            "bucket {} ({}): {} graphs, candidate {}",
+            bucket,
+            conditions_to_string(buckets[bucket]),
+            number_of_graphs[bucket],
+            best
+        );
+        rules.push_back({buckets[bucket], candidates[best]});
+    }
+    std::ofstream file(output);
+    if (!file.is_open()) {
+        std::println("could not write {}", output.string());
+        return 1;
+    }
+    file << shape::SolverRules(std::move(rules)).to_config();
+    std::println(
+        "rules written to {}, use them with sat_rules={}", output.string(), output.string()
+    );
+    return 0;
+}
+
+// draws every graph starting from each kind of cycle basis, the literals of the cycle clauses
+// grow with the lengths of the cycles
+int compare_cycle_bases(const std::filesystem::path& directory) {
+    const std::vector<shape::CycleBasis> bases = {
+        shape::CycleBasis::SPANNING_TREE,
+        shape::CycleBasis::BREADTH_FIRST_TREE,
+        shape::CycleBasis::SHORT_CYCLES,
+    };
+    std::println(
+        "{:<24} {:<20} {:>8} {:>8} {:>12} {:>8}",
+        "graph",
+        "basis",
+        "cycles",
+        "length",
+        "ms",
+        "bends"
+    );
+    std::vector<size_t> total_lengths(bases.size(), 0);
+    std::vector<double> total_milliseconds(bases.size(), 0.0);
+    for (const auto& [name, graph] : load_benchmark_graphs(directory)) {
+        for (size_t i = 0; i < bases.size(); ++i) {
+            const std::vector<graph::Cycle> cycles = compute_cycle_basis(graph, bases[i]);
+            size_t length = 0;
+            for (const graph::Cycle& cycle : cycles)
+                length += cycle.size();
+            shape::ShapeBuilderOptions options;
+            options.cycle_basis = bases[i];
+            const auto [milliseconds, bends] = run(graph, options);
+            total_lengths[i] += length;
+            total_milliseconds[i] += milliseconds;
+            std::println(
+                "{:<24} {:<20} {:>8} {:>8} {:>12.1f} {:>8}",
+                name,
+                shape::cycle_basis_to_string(bases[i]),
+                cycles.size(),
+                length,
+                milliseconds,
+                bends
+            );
+        }
+    }
+    for (size_t i = 0; i < bases.size(); ++i)
+        std::println(
+            "{:<24} {:<20} {:>8} {:>8} {:>12.1f}",
+            "total",
+            shape::cycle_basis_to_string(bases[i]),
+            "",
+            total_lengths[i],
+            total_milliseconds[i]
+        );
+    return 0;
+}
+
+// usage: domus-bench [graphs directory], the directory defaults to example-graphs
+//        domus-bench --calibrate <rules file> [graphs directory]
+//        domus-bench --cycle-bases [graphs directory]
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string_view(argv[1]) == "--calibrate") {
+        if (argc < 3) {
+            std::println("usage: domus-bench --calibrate <rules file> [graphs directory]");
+            return 1;
+        }
+        return calibrate(argv[2], argc > 3 ? argv[3] : "example-graphs");
+    }
+    if (argc > 1 && std::string_view(argv[1]) == "--cycle-bases")
+        return compare_cycle_bases(argc > 2 ? argv[2] : "example-graphs");
+    const std::filesystem::path directory = argc > 1 ? argv[1] : "example-graphs";
+    shape::ShapeBuilderOptions plain;
+    shape::ShapeBuilderOptions symmetry_breaking;
+    symmetry_breaking.break_symmetries = true;
+    std::println(
+        "{:<24} {:>12} {:>8} {:>12} {:>8}", "graph", "plain ms", "bends", "sym ms", "bends"
+    );
+    double total_plain = 0.0;
+    double total_symmetry_breaking = 0.0;
+    for (const auto& [name, graph] : load_benchmark_graphs(directory)) {
+        const auto [plain_ms, plain_bends] = run(graph, plain);
+        const auto [symmetry_ms, symmetry_bends] = run(graph, symmetry_breaking);
+        total_plain += plain_ms;
+        total_symmetry_breaking += symmetry_ms;
+        std::println(
+            "{:<24} {:>12.1f} {:>8} {:>12.1f} {:>8}",
+            name,
+            plain_ms,
+            plain_bends,
+            symmetry_ms,
+            symmetry_bends
+        );
+    }
+    std::println(
+        "{:<24} {:>12.1f} {:>8} {:>12.1f}", "total", total_plain, "", total_symmetry_breaking
+    );
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "domus/sat/cnf.hpp"
+#include "domus/sat/sat.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+using namespace domus;
+using namespace domus::sat;
+
+// the file is mapped in memory and parsed in place
+std::expected<cnf::Cnf, std::string> load_cnf(const std::filesystem::path& path) {
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return std::unexpected(std::format("could not open {}", path.string()));
+    struct stat status{};
+    if (fstat(file, &status) != 0) {
+        close(file);
+        return std::unexpected(std::format("could not read the size of {}", path.string()));
+    }
+    const size_t size = static_cast<size_t>(status.st_size);
+    if (size == 0) {
+        close(file);
+        return cnf::Cnf{};
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+        return std::unexpected(std::format("could not map {}", path.string()));
+    madvise(data, size, MADV_SEQUENTIAL);
+    auto cnf = cnf::Cnf::parse_dimacs(std::string_view(static_cast<const char*>(data), size));
+    munmap(data, size);
+    return cnf;
+}
+
+// the result written by the dump, std::nullopt if missing
+std::optional<SatSolverResultType> get_dumped_result(const cnf::Cnf& cnf) {
+    constexpr std::string_view prefix = "domus result ";
+    for (const auto& [clause_index, comment] : cnf.get_comments())
+        if (comment.starts_with(prefix)) {
+            const std::string_view result = std::string_view(comment).substr(prefix.size());
+            for (SatSolverResultType type : {
+                     SatSolverResultType::SAT,
+                     SatSolverResultType::UNSAT,
+                     SatSolverResultType::UNKNOWN,
+                 })
+                if (result == sat_solver_result_type_to_string(type))
+                    return type;
+        }
+    return std::nullopt;
+}
+
+bool is_2_sat(const cnf::Cnf& cnf) {
+    return std::ranges::all_of(cnf.get_clauses(), [](std::span<const int> clause) {
+        return clause.size() <= 2;
+    });
+}
+
+// milliseconds of the whole replay (clauses and solve) and result
+std::pair<double, SatSolverResultType> replay(const cnf::Cnf& cnf, SatBackendType type) {
+    const auto start = std::chrono::steady_clock::now();
+    // the types come from string_to_sat_backend_type, so they can be created
+    std::unique_ptr<SatBackend> backend = SatBackend::create(type).value();
+    backend->reserve_variables(cnf.get_number_of_variables());
+    for (std::span<const int> clause : cnf.get_clauses())
+        backend->add_clause(clause);
+    const SatSolverResult result = backend->solve({});
+    const auto end = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::milli>(end - start).count(), result.result};
+}
+
+std::vector<std::filesystem::path> list_cnf_files(const std::filesystem::path& directory) {
+    std::vector<std::filesystem::path> paths;
+    if (std::filesystem::is_directory(directory))
+        for (const auto& entry : std::filesystem::directory_iterator(directory))
+            if (entry.path().extension() == ".cnf")
+                paths.push_back(entry.path());
+    std::ranges::sort(paths);
+    return paths;
+}
+
+// usage: domus-cnf-bench <directory> [backends...]
+// replays the formulas dumped with the cnf_dump_dir option against the given backends
+// (all the available ones by default), a result different from the dumped one is marked
+// with '!', '-' marks a formula with long clauses that the 2-sat backend cannot solve
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::println("usage: domus-cnf-bench <directory> [backends...]");
+        return 1;
+    }
+    const std::filesystem::path directory = argv[1];
+    std::vector<SatBackendType> backends;
+    if (argc > 2)
+        for (int i = 2; i < argc; ++i) {
+            auto type = string_to_sat_backend_type(argv[i]);
+            if (!type) {
+                std::println("{}", type.error());
+                return 1;
+            }
+            backends.push_back(*type);
+        }
+    else
+        for (const std::string name :
+             {"glucose",
+              "glucose-parallel",
+              "kissat",
+              "portfolio",
+              "cube-and-conquer",
+              "2-sat",
+              "ipasir"})
+            if (auto type = string_to_sat_backend_type(name))
+                backends.push_back(*type);
+    const std::vector<std::filesystem::path> paths = list_cnf_files(directory);
+    if (paths.empty()) {
+        std::println("no .cnf files in {}", directory.string());
+        return 1;
+    }
+    std::string header = std::format(
+        "{:<14} {:>10} {:>10} {:>8} {:>10}", "formula", "variables", "clauses", "result", "parse ms"
+    );
+    for (SatBackendType type : backends)
+        header += std::format(" {:>17}", sat_backend_type_to_string(type) + " ms");
+    std::println("{}", header);
+    double total_parse = 0.0;
+    std::vector<double> totals(backends.size(), 0.0);
+    size_t number_of_mismatches = 0;
+    for (const std::filesystem::path& path : paths) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto cnf = load_cnf(path);
+        const auto end = std::chrono::steady_clock::now();
+        if (!cnf) {
+            std::println("skipping {}: {}", path.string(), cnf.error());
+            continue;
+        }
+        const double parse_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        total_parse += parse_ms;
+        const std::optional<SatSolverResultType> expected = get_dumped_result(*cnf);
+        std::string line = std::format(
+            "{:<14} {:>10} {:>10} {:>8} {:>10.2f}",
+            path.filename().string(),
+            cnf->get_number_of_variables(),
+            cnf->get_number_of_clauses(),
+            expected.has_value() ? sat_solver_result_type_to_string(*expected) : "?",
+            parse_ms
+        );
+        for (size_t i = 0; i < backends.size(); ++i) {
+            if (backends[i] == SatBackendType::TWO_SAT && !is_2_sat(*cnf)) {
+                line += std::format(" {:>17}", "-");
+                continue;
+            }
+            const auto [milliseconds, result] = replay(*cnf, backends[i]);
+            totals[i] += milliseconds;
+            // an UNKNOWN dump ran out of budget, any answer is fine
+            const bool is_mismatch = expected.has_value() &&
+                                     *expected != SatSolverResultType::UNKNOWN &&
+                                     result != *expected;
+            if (is_mismatch)
+                number_of_mismatches++;
+            line += std::format(" {:>16.2f}{}", milliseconds, is_mismatch ? "!" : " ");
+        }
+        std::println("{}", line);
+    }
+    std::string total_line =
+        std::format("{:<14} {:>10} {:>10} {:>8} {:>10.2f}", "total", "", "", "", total_parse);
+    for (double total : totals)
+        total_line += std::format(" {:>16.2f} ", total);
+    std::println("{}", total_line);
+    if (number_of_mismatches > 0) {
+        std::println("{} replays disagree with the dumped result", number_of_mismatches);
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -2,11 +2,13 @@
 #include <print>
 #include <string>
 
+#include "domus/core/config.hpp"
 #include "domus/core/graph/file_loader.hpp"
 #include "domus/core/graph/graph.hpp"
 #include "domus/orthogonal/drawing.hpp"
 #include "domus/orthogonal/drawing_builder.hpp"
 #include "domus/orthogonal/drawing_stats.hpp"
+#include "domus/orthogonal/shape/shape_builder.hpp"
 #include "domus/planarity/auslander_parter.hpp"
 #include "domus/planarity/embedding.hpp"
 
@@ -48,7 +50,24 @@ int main() {
         return 1;
     }
     graph->print(true);
-    const auto result = make_orthogonal_drawing(*graph);
+    shape::ShapeBuilderOptions options;
+    if (std::filesystem::exists("domus.conf")) {
+        const auto config_options =
+            Config::create("domus.conf").and_then([](const auto& config) {
+                return shape::get_shape_builder_options(*config);
+            });
+        if (!config_options) {
+            println("{}", config_options.error());
+            return 1;
+        }
+        options = *config_options;
+    }
+    const auto drawing_result = make_orthogonal_drawing(*graph, options);
+    if (!drawing_result) {
+        println("{}", drawing_result.error());
+        return 1;
+    }
+    const ShapeMetricsDrawing& result = *drawing_result;
     make_svg(
         result.drawing.augmented_graph,
         result.drawing.attributes,
@@ -60,6 +79,8 @@ int main() {
     std::println("Initial number of cycles: {}", result.initial_number_of_cycles);
     std::println("Number of added cycles: {}", result.number_of_added_cycles);
     std::println("Number of useless bends: {}", result.number_of_useless_bends);
+    std::println("SAT solver: {}", result.sat_stats.to_string());
+    std::println("Splits: {}", result.split_stats.to_string());
     planarity_test();
     return 0;
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "domus/core/graph/path.hpp"
 #include "domus/orthogonal/area_compacter.hpp"
 #include "domus/orthogonal/equivalence_classes.hpp"
+#include "domus/orthogonal/incremental_ordering.hpp"
 #include "domus/orthogonal/shape/direction.hpp"
 #include "domus/orthogonal/shape/shape.hpp"
 #include "domus/orthogonal/shape/shape_builder.hpp"
@@ -25,8 +26,9 @@
 
 namespace domus::orthogonal {
 using namespace domus::graph;
-using shape::build_shape;
 using shape::Direction;
+using shape::ShapeBuilder;
+using shape::ShapeBuilderOptions;
 
 const Path path_in_class(
     const Graph& graph, size_t from_id, size_t to_id, const Shape& shape, bool go_horizontal
@@ -228,9 +230,33 @@ remove_useless_bends(const Graph& graph, const Attributes& attributes, const Sha
     return {std::move(new_graph), std::move(new_attributes), std::move(new_shape)};
 }
 
-ShapeMetricsDrawing make_orthogonal_drawing_incremental(Graph& graph, std::vector<Cycle>& cycles);
+std::expected<ShapeMetricsDrawing, std::string> make_orthogonal_drawing_incremental(
+    Graph& graph, std::vector<Cycle>& cycles, const ShapeBuilderOptions& options
+);
 
-ShapeMetricsDrawing make_orthogonal_drawing(const Graph& graph) {
+ShapeMetricsDrawing make_orthogonal_drawing(const Graph& graph, sat::SatBackendType backend_type) {
+    ShapeBuilderOptions options;
+    options.backend_type = backend_type;
+    // without a budget the drawing fails only with 2-sat
+    return make_orthogonal_drawing(graph, options).value();
+}
+
+std::vector<Cycle> compute_cycle_basis(const Graph& graph, shape::CycleBasis basis) {
+    switch (basis) {
+    case shape::CycleBasis::SPANNING_TREE:
+        return algorithms::compute_cycle_basis(graph);
+    case shape::CycleBasis::BREADTH_FIRST_TREE:
+        return algorithms::compute_breadth_first_cycle_basis(graph);
+    case shape::CycleBasis::SHORT_CYCLES:
+        return algorithms::compute_short_cycle_basis(graph);
+    default:
+        DOMUS_ASSERT(false, "compute_cycle_basis: invalid basis");
+        return {};
+    }
+}
+
+std::expected<ShapeMetricsDrawing, std::string>
+make_orthogonal_drawing(const Graph& graph, const ShapeBuilderOptions& options) {
     Graph augmented_graph;
     for (size_t i = 0; i < graph.get_number_of_nodes(); ++i)
         augmented_graph.add_node();
@@ -238,46 +264,83 @@ ShapeMetricsDrawing make_orthogonal_drawing(const Graph& graph) {
         for (size_t neighbor_id : graph.get_out_neighbors(node_id))
             augmented_graph.add_edge(node_id, neighbor_id);
 
-    auto cycles = algorithms::compute_cycle_basis(augmented_graph);
-    return make_orthogonal_drawing_incremental(augmented_graph, cycles);
+    std::vector<Cycle> cycles;
+    if (!options.lazy_cycles)
+        cycles = compute_cycle_basis(augmented_graph, options.cycle_basis);
+    return make_orthogonal_drawing_incremental(augmented_graph, cycles, options);
 }
 
-std::optional<Cycle> check_if_metrics_exist(Shape& shape, Graph& graph) {
-    const auto [classes_x, classes_y] = EquivalenceClasses::build(shape, graph);
-    Ordering ordering = Ordering::build(classes_x, classes_y, graph, shape);
-    std::optional<Cycle> cycle_x =
-        algorithms::find_a_directed_cycle_in_graph(ordering.get_ordering_x());
-    std::optional<Cycle> cycle_y =
-        algorithms::find_a_directed_cycle_in_graph(ordering.get_ordering_y());
-    if (cycle_x.has_value()) {
-        DOMUS_ASSERT(
-            algorithms::is_cycle_in_graph(ordering.get_ordering_x(), *cycle_x),
-            "check_if_metrics_exist: cycle_x is not in ordering_x"
-        );
-        return build_cycle_in_graph_from_cycle_in_ordering(
-            classes_x,
-            graph,
-            shape,
-            cycle_x.value(),
-            ordering.get_ordering_x_edge_to_graph_edge(),
-            false
-        );
-    }
-    if (cycle_y.has_value()) {
-        DOMUS_ASSERT(
-            algorithms::is_cycle_in_graph(ordering.get_ordering_y(), *cycle_y),
-            "check_if_metrics_exist: cycle_y is not in ordering_y"
-        );
-        return build_cycle_in_graph_from_cycle_in_ordering(
-            classes_y,
-            graph,
-            shape,
-            cycle_y.value(),
-            ordering.get_ordering_y_edge_to_graph_edge(),
-            true
-        );
+bool have_same_edges(const Cycle& cycle_1, const Cycle& cycle_2) {
+    if (cycle_1.size() != cycle_2.size())
+        return false;
+    for (size_t i = 0; i < cycle_1.size(); ++i)
+        if (!cycle_2.has_edge_id(cycle_1.edge_id_at(i)))
+            return false;
+    return true;
+}
+
+// an edge with both ends in the same class of the other axis cannot get a length, the cycle it
+// closes with the path in the class does not turn in all four directions
+void add_cycles_of_collapsed_edges(
+    const AxisOrdering& axis_ordering,
+    const Shape& shape,
+    const Graph& graph,
+    bool go_horizontal,
+    std::vector<Cycle>& cycles
+) {
+    const EquivalenceClasses& classes = axis_ordering.get_classes();
+    graph.for_each_node([&](size_t node_id) {
+        graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t neighbor_id) {
+            if (shape.is_horizontal(edge_id) == go_horizontal)
+                return;
+            if (classes.get_class_of_elem(node_id) != classes.get_class_of_elem(neighbor_id))
+                return;
+            Path path = path_in_class(graph, neighbor_id, node_id, shape, go_horizontal);
+            path.push_front(graph, neighbor_id, edge_id);
+            cycles.emplace_back(path);
+        });
+    });
+}
+
+// the cycles of the graph behind a set of disjoint short cycles of each ordering, so that a
+// single call of build_shape fixes all of them, and the cycles of the collapsed edges;
+// empty if the metrics exist, that is if every cycle turns in all four directions
+std::vector<Cycle> check_if_metrics_exist(
+    const IncrementalOrdering& ordering, const Shape& shape, const Graph& graph
+) {
+    std::vector<Cycle> cycles;
+    auto add_cycles = [&](const AxisOrdering& axis_ordering, bool go_horizontal) {
+        if (!axis_ordering.has_cycle())
+            return;
+        const Graph& ordering_graph = axis_ordering.get_ordering();
+        for (const Cycle& cycle_in_ordering :
+             algorithms::find_short_disjoint_directed_cycles(ordering_graph)) {
+            DOMUS_ASSERT(
+                algorithms::is_cycle_in_graph(ordering_graph, cycle_in_ordering),
+                "check_if_metrics_exist: cycle is not in the ordering"
+            );
+            Cycle cycle = build_cycle_in_graph_from_cycle_in_ordering(
+                axis_ordering.get_classes(),
+                graph,
+                shape,
+                cycle_in_ordering,
+                axis_ordering.get_ordering_edge_to_graph_edge(),
+                go_horizontal
+            );
+            if (std::ranges::none_of(cycles, [&](const Cycle& other) {
+                    return have_same_edges(cycle, other);
+                }))
+                cycles.push_back(std::move(cycle));
+        }
+    };
+    add_cycles(ordering.get_ordering_x(), false);
+    add_cycles(ordering.get_ordering_y(), true);
+    // a collapsed edge mostly comes with a cycle of the orderings, looked for only without them
+    if (cycles.empty()) {
+        add_cycles_of_collapsed_edges(ordering.get_ordering_x(), shape, graph, false, cycles);
+        add_cycles_of_collapsed_edges(ordering.get_ordering_y(), shape, graph, true, cycles);
     }
-    return std::nullopt;
+    return cycles;
 }
 
 void build_nodes_positions(Graph& graph, Attributes& attributes, Shape& shape);
@@ -306,18 +369,31 @@ void build_nodes_position_degree_more_than_4(
     fix_negative_positions(augmented_graph, attributes);
 }
 
-ShapeMetricsDrawing make_orthogonal_drawing_incremental(Graph& graph, std::vector<Cycle>& cycles) {
+std::expected<ShapeMetricsDrawing, std::string> make_orthogonal_drawing_incremental(
+    Graph& graph, std::vector<Cycle>& cycles, const ShapeBuilderOptions& options
+) {
     Attributes attributes;
     attributes.add_attribute(Attribute::NODES_COLOR);
     graph.for_each_node([&](size_t node_id) { attributes.set_node_color(node_id, Color::BLACK); });
-    Shape shape = build_shape(graph, attributes, cycles);
-    std::optional<Cycle> cycle_to_add = check_if_metrics_exist(shape, graph);
+    ShapeBuilder shape_builder(options);
+    auto built_shape = shape_builder.build_shape(graph, attributes, cycles);
+    if (!built_shape)
+        return std::unexpected(built_shape.error());
+    Shape shape = std::move(*built_shape);
+    // kept up to date with the shapes of the loop instead of built again for each one
+    IncrementalOrdering ordering(graph, shape);
+    std::vector<Cycle> cycles_to_add = check_if_metrics_exist(ordering, shape, graph);
     size_t number_of_added_cycles = 0;
-    while (cycle_to_add.has_value()) {
-        cycles.push_back(std::move(*cycle_to_add));
-        number_of_added_cycles++;
-        shape = build_shape(graph, attributes, cycles);
-        cycle_to_add = check_if_metrics_exist(shape, graph);
+    while (!cycles_to_add.empty()) {
+        for (Cycle& cycle : cycles_to_add)
+            cycles.push_back(std::move(cycle));
+        number_of_added_cycles += cycles_to_add.size();
+        built_shape = shape_builder.build_shape(graph, attributes, cycles);
+        if (!built_shape)
+            return std::unexpected(built_shape.error());
+        shape = std::move(*built_shape);
+        ordering.update(graph, shape);
+        cycles_to_add = check_if_metrics_exist(ordering, shape, graph);
     }
     const size_t old_size = graph.get_number_of_nodes();
     auto [new_graph, new_attributes, new_shape] = remove_useless_bends(graph, attributes, shape);
@@ -338,28 +414,35 @@ ShapeMetricsDrawing make_orthogonal_drawing_incremental(Graph& graph, std::vecto
         build_nodes_positions(graph, attributes, shape);
     compact_area(graph, attributes);
     OrthogonalDrawing drawing{std::move(graph), std::move(attributes), std::move(shape)};
-    return {
+    return ShapeMetricsDrawing{
         std::move(drawing),
         number_of_cycles - number_of_added_cycles,
         number_of_added_cycles,
-        number_of_useless_bends
+        number_of_useless_bends,
+        shape_builder.get_sat_stats(),
+        shape_builder.get_split_stats()
     };
 }
 
-void find_inconsistencies(Graph& graph, Shape& shape, Attributes& attributes);
+void find_inconsistencies(
+    Graph& graph, Shape& shape, Attributes& attributes, IncrementalOrdering& ordering
+);
 
 void build_nodes_positions(Graph& graph, Attributes& attributes, Shape& shape) {
-    find_inconsistencies(graph, shape, attributes);
-    auto [classes_x, classes_y] = EquivalenceClasses::build(shape, graph);
-    Ordering ordering = Ordering::build(classes_x, classes_y, graph, shape);
+    IncrementalOrdering ordering(graph, shape);
+    find_inconsistencies(graph, shape, attributes, ordering);
+    const EquivalenceClasses& classes_x = ordering.get_ordering_x().get_classes();
+    const EquivalenceClasses& classes_y = ordering.get_ordering_y().get_classes();
 
     auto new_classes_x_ordering =
-        algorithms::make_topological_ordering(ordering.get_ordering_x()).value();
+        algorithms::make_topological_ordering(ordering.get_ordering_x().get_ordering()).value();
     auto new_classes_y_ordering =
-        algorithms::make_topological_ordering(ordering.get_ordering_y()).value();
+        algorithms::make_topological_ordering(ordering.get_ordering_y().get_ordering()).value();
     size_t current_position_x = 0;
     utilities::NodesLabels node_id_to_position_x(graph);
     for (size_t class_id : new_classes_x_ordering) {
+        if (classes_x.number_of_elems_in_class(class_id) == 0)
+            continue;
         classes_x.for_each_elem_of_class(class_id, [&](size_t node_id) {
             if (attributes.get_node_color(node_id) == Color::BLUE)
                 current_position_x += 100;
@@ -372,6 +455,8 @@ void build_nodes_positions(Graph& graph, Attributes& attributes, Shape& shape) {
     size_t current_position_y = 0;
     utilities::NodesLabels node_id_to_position_y(graph);
     for (size_t class_id : new_classes_y_ordering) {
+        if (classes_y.number_of_elems_in_class(class_id) == 0)
+            continue;
         classes_y.for_each_elem_of_class(class_id, [&](size_t node_id) {
             if (attributes.get_node_color(node_id) == Color::GREEN)
                 current_position_y += 100;
@@ -628,7 +713,8 @@ void add_green_blue_nodes(Graph& graph, Attributes& attributes, Shape& shape) {
     shape = std::move(new_shape);
 }
 
-void fix_inconsistency(
+// returns the edge whose direction changed
+size_t fix_inconsistency(
     const Cycle& cycle,
     Attributes& attributes,
     const Graph& graph,
@@ -653,47 +739,46 @@ void fix_inconsistency(
         edge_ids[i] = edge_id;
         ++i;
     });
-    if (shape.is_up(graph, edge_ids[0], neighbors_ids[0], colored_node_id)) {
-        shape.remove_direction(edge_ids[0]);
-        shape.set_direction(graph, edge_ids[0], colored_node_id, neighbors_ids[0], direction);
-    } else {
-        shape.remove_direction(edge_ids[1]);
-        shape.set_direction(graph, edge_ids[1], colored_node_id, neighbors_ids[1], direction);
-    }
+    const size_t index =
+        shape.is_up(graph, edge_ids[0], neighbors_ids[0], colored_node_id) ? 0 : 1;
+    shape.remove_direction(edge_ids[index]);
+    shape.set_direction(graph, edge_ids[index], colored_node_id, neighbors_ids[index], direction);
     attributes.change_node_color(colored_node_id, dark_color);
+    return edge_ids[index];
 }
 
-void find_inconsistencies(Graph& graph, Shape& shape, Attributes& attributes) {
-    auto [classes_x, classes_y] = EquivalenceClasses::build(shape, graph);
-    Ordering ordering = Ordering::build(classes_x, classes_y, graph, shape);
-    std::optional<Cycle> cycle_x =
-        algorithms::find_a_directed_cycle_in_graph(ordering.get_ordering_x());
-    std::optional<Cycle> cycle_y =
-        algorithms::find_a_directed_cycle_in_graph(ordering.get_ordering_y());
-    if (cycle_x.has_value() || cycle_y.has_value()) {
-        if (cycle_x.has_value()) {
-            Cycle cycle = build_cycle_in_graph_from_cycle_in_ordering(
-                classes_x,
-                graph,
-                shape,
-                cycle_x.value(),
-                ordering.get_ordering_x_edge_to_graph_edge(),
-                false
-            );
-            fix_inconsistency(cycle, attributes, graph, shape, Color::BLUE);
-        } else {
-            Cycle cycle = build_cycle_in_graph_from_cycle_in_ordering(
-                classes_x,
-                graph,
-                shape,
-                cycle_y.value(),
-                ordering.get_ordering_y_edge_to_graph_edge(),
-                true
-            );
-            fix_inconsistency(cycle, attributes, graph, shape, Color::GREEN);
-        }
-        find_inconsistencies(graph, shape, attributes);
+void find_inconsistencies(
+    Graph& graph, Shape& shape, Attributes& attributes, IncrementalOrdering& ordering
+) {
+    const AxisOrdering& ordering_x = ordering.get_ordering_x();
+    const AxisOrdering& ordering_y = ordering.get_ordering_y();
+    if (!ordering_x.has_cycle() && !ordering_y.has_cycle())
+        return;
+    size_t changed_edge_id;
+    if (ordering_x.has_cycle()) {
+        Cycle cycle = build_cycle_in_graph_from_cycle_in_ordering(
+            ordering_x.get_classes(),
+            graph,
+            shape,
+            ordering_x.find_cycle().value(),
+            ordering_x.get_ordering_edge_to_graph_edge(),
+            false
+        );
+        changed_edge_id = fix_inconsistency(cycle, attributes, graph, shape, Color::BLUE);
+    } else {
+        Cycle cycle = build_cycle_in_graph_from_cycle_in_ordering(
+            ordering_y.get_classes(),
+            graph,
+            shape,
+            ordering_y.find_cycle().value(),
+            ordering_y.get_ordering_edge_to_graph_edge(),
+            true
+        );
+        changed_edge_id = fix_inconsistency(cycle, attributes, graph, shape, Color::GREEN);
     }
+    const size_t changed_edge_ids[] = {changed_edge_id};
+    ordering.update(graph, shape, changed_edge_ids);
+    find_inconsistencies(graph, shape, attributes, ordering);
 }
 
 template <typename Func>
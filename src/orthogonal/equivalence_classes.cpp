@@ -14,10 +14,23 @@ using Graph = graph::Graph;
 EquivalenceClasses::EquivalenceClasses(const Graph& graph) : m_elem_to_class(graph) {}
 
 size_t EquivalenceClasses::add_class() {
+    if (!m_free_class_ids.empty()) {
+        const size_t class_id = m_free_class_ids.back();
+        m_free_class_ids.pop_back();
+        return class_id;
+    }
     m_class_to_elems.push_back({});
     return m_number_of_classes++;
 }
 
+void EquivalenceClasses::remove_class(size_t class_id) {
+    DOMUS_ASSERT(has_class(class_id), "EquivalenceClasses::remove_class class does not exist");
+    for (size_t elem : m_class_to_elems[class_id])
+        m_elem_to_class.erase_label(elem);
+    m_class_to_elems[class_id].clear();
+    m_free_class_ids.push_back(class_id);
+}
+
 bool EquivalenceClasses::has_class(size_t class_id) const { return class_id < m_number_of_classes; }
 
 void EquivalenceClasses::set_class(size_t elem, size_t class_id) {
@@ -53,6 +66,8 @@ size_t EquivalenceClasses::number_of_elems_in_class(size_t class_id) const {
     return m_class_to_elems.at(class_id).size();
 }
 
+size_t EquivalenceClasses::get_number_of_classes() const { return m_number_of_classes; }
+
 void EquivalenceClasses::for_each_class(std::function<void(size_t)> f) const {
     for (size_t class_id = 0; class_id < m_number_of_classes; ++class_id)
         f(class_id);
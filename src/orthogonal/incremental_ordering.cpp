@@ -0,0 +1,427 @@
+#include "domus/orthogonal/incremental_ordering.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <queue>
+#include <span>
+#include <vector>
+
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+#include "domus/core/graph/path.hpp"
+#include "domus/orthogonal/shape/direction.hpp"
+
+#include "../core/domus_debug.hpp"
+
+namespace domus::orthogonal {
+using namespace graph;
+using shape::Direction;
+
+AxisOrdering::AxisOrdering(const Graph& graph, bool is_x)
+    : m_is_x(is_x), m_classes(graph), m_ordering_edge_to_graph_edge(size_t{0}) {}
+
+void AxisOrdering::update(
+    const Graph& graph,
+    const Shape& shape,
+    std::span<const size_t> changed_edge_ids,
+    std::span<const size_t> touched_node_ids
+) {
+    if (graph.get_number_of_nodes() > 0)
+        m_classes.m_elem_to_class.update_size(graph.get_number_of_nodes() - 1);
+    std::vector<size_t> nodes;
+    std::vector<size_t> touched_classes;
+    size_t number_of_touched_nodes = 0;
+    for (size_t node_id : touched_node_ids) {
+        if (!m_classes.has_elem_a_class(node_id)) {
+            nodes.push_back(node_id);
+            number_of_touched_nodes++;
+            continue;
+        }
+        const size_t class_id = m_classes.get_class_of_elem(node_id);
+        if (m_is_visited[class_id])
+            continue;
+        m_is_visited[class_id] = true;
+        touched_classes.push_back(class_id);
+        number_of_touched_nodes += m_classes.number_of_elems_in_class(class_id);
+    }
+    for (size_t class_id : touched_classes)
+        m_is_visited[class_id] = false;
+    if (4 * number_of_touched_nodes > graph.get_number_of_nodes()) {
+        rebuild(graph, shape);
+        return;
+    }
+    for (size_t edge_id : changed_edge_ids)
+        remove_graph_edge(edge_id);
+    // the touched classes are removed with the ordering edges of their nodes
+    for (size_t class_id : touched_classes) {
+        m_classes.for_each_elem_of_class(class_id, [&](size_t elem) {
+            nodes.push_back(elem);
+            for (auto [edge_id, neighbor_id] : graph.get_edges(elem))
+                remove_graph_edge(edge_id);
+        });
+        m_classes.remove_class(class_id);
+    }
+    for (size_t node_id : nodes) {
+        if (m_classes.has_elem_a_class(node_id))
+            continue;
+        if (m_is_x)
+            m_classes.vertical_node_expander(shape, graph, node_id);
+        else
+            m_classes.horizontal_node_expander(shape, graph, node_id);
+    }
+    add_ordering_nodes();
+    for (size_t node_id : nodes)
+        for (auto [edge_id, neighbor_id] : graph.get_edges(node_id))
+            add_graph_edge(graph, shape, edge_id, true);
+    retry_set_aside_edges();
+}
+
+void AxisOrdering::rebuild(const Graph& graph, const Shape& shape) {
+    *this = AxisOrdering(graph, m_is_x);
+    graph.for_each_node([&](size_t node_id) {
+        if (m_classes.has_elem_a_class(node_id))
+            return;
+        if (m_is_x)
+            m_classes.vertical_node_expander(shape, graph, node_id);
+        else
+            m_classes.horizontal_node_expander(shape, graph, node_id);
+    });
+    add_ordering_nodes();
+    // the edges in the same order as Ordering::build
+    const Direction forward = m_is_x ? Direction::RIGHT : Direction::UP;
+    graph.for_each_node([&](size_t node_id) {
+        graph.for_each_edge(node_id, [&](size_t edge_id, size_t neighbor_id) {
+            if (shape.get_direction(graph, edge_id, node_id, neighbor_id) == forward)
+                add_graph_edge(graph, shape, edge_id, false);
+        });
+    });
+    compute_order();
+}
+
+// a new class goes at the end of the topological order
+void AxisOrdering::add_ordering_nodes() {
+    while (m_ordering.get_number_of_nodes() < m_classes.get_number_of_classes()) {
+        const size_t class_id = m_ordering.add_node();
+        m_position.push_back(m_class_at.size());
+        m_class_at.push_back(class_id);
+        m_is_visited.push_back(false);
+    }
+}
+
+void AxisOrdering::add_graph_edge(
+    const Graph& graph, const Shape& shape, size_t edge_id, bool keep_order
+) {
+    if (m_graph_edge_links.size() <= edge_id)
+        m_graph_edge_links.resize(edge_id + 1);
+    if (m_graph_edge_links[edge_id].has_value())
+        return;
+    const Direction forward = m_is_x ? Direction::RIGHT : Direction::UP;
+    auto [from_id, to_id] = graph.get_edge(edge_id);
+    const Direction direction = shape.get_direction(edge_id);
+    if (direction == shape::opposite_direction(forward))
+        std::swap(from_id, to_id);
+    else if (direction != forward)
+        return;
+    const size_t class_from = m_classes.get_class_of_elem(from_id);
+    const size_t class_to = m_classes.get_class_of_elem(to_id);
+    if (class_from == class_to)
+        return;
+    std::optional<size_t> ordering_edge_id;
+    for (const auto [id, neighbor_id] : m_ordering.get_out_edges(class_from))
+        if (neighbor_id == class_to)
+            ordering_edge_id = id;
+    // the label (the first edge of the list) stays the same
+    if (ordering_edge_id.has_value()) {
+        const size_t first_edge_id = m_ordering_edge_to_graph_edge.get_label(*ordering_edge_id);
+        GraphEdgeLink& first_link = *m_graph_edge_links[first_edge_id];
+        if (first_link.next_edge_id.has_value())
+            m_graph_edge_links[*first_link.next_edge_id]->previous_edge_id = edge_id;
+        m_graph_edge_links[edge_id] =
+            GraphEdgeLink{*ordering_edge_id, first_edge_id, first_link.next_edge_id};
+        first_link.next_edge_id = edge_id;
+        return;
+    }
+    ordering_edge_id = m_ordering.add_edge(class_from, class_to);
+    m_ordering_edge_to_graph_edge.update_size(*ordering_edge_id);
+    m_ordering_edge_to_graph_edge.add_label(*ordering_edge_id, edge_id);
+    m_graph_edge_links[edge_id] = GraphEdgeLink{*ordering_edge_id, std::nullopt, std::nullopt};
+    if (m_is_set_aside.size() <= *ordering_edge_id)
+        m_is_set_aside.resize(*ordering_edge_id + 1, false);
+    if (keep_order)
+        insert_ordering_edge(*ordering_edge_id);
+}
+
+void AxisOrdering::remove_graph_edge(size_t edge_id) {
+    if (m_graph_edge_links.size() <= edge_id || !m_graph_edge_links[edge_id].has_value())
+        return;
+    const auto [ordering_edge_id, previous_edge_id, next_edge_id] = *m_graph_edge_links[edge_id];
+    m_graph_edge_links[edge_id].reset();
+    if (next_edge_id.has_value())
+        m_graph_edge_links[*next_edge_id]->previous_edge_id = previous_edge_id;
+    if (previous_edge_id.has_value()) {
+        m_graph_edge_links[*previous_edge_id]->next_edge_id = next_edge_id;
+        return;
+    }
+    if (next_edge_id.has_value()) {
+        m_ordering_edge_to_graph_edge.update_label(ordering_edge_id, *next_edge_id);
+        return;
+    }
+    m_ordering_edge_to_graph_edge.erase_label(ordering_edge_id);
+    if (m_is_set_aside[ordering_edge_id]) {
+        m_is_set_aside[ordering_edge_id] = false;
+        std::erase(m_set_aside_edges, ordering_edge_id);
+    } else
+        m_has_removed_edges = true;
+    m_ordering.remove_edge(ordering_edge_id);
+}
+
+// the classes reachable from class_id before upper_position, false if the class at
+// upper_position is reachable (the new edge closes a cycle)
+bool AxisOrdering::collect_forward(
+    size_t class_id, size_t upper_position, std::vector<size_t>& classes
+) {
+    std::vector<size_t> stack{class_id};
+    m_is_visited[class_id] = true;
+    classes.push_back(class_id);
+    while (!stack.empty()) {
+        const size_t current = stack.back();
+        stack.pop_back();
+        for (const auto [edge_id, neighbor_id] : m_ordering.get_out_edges(current)) {
+            if (m_is_set_aside[edge_id])
+                continue;
+            if (m_position[neighbor_id] == upper_position)
+                return false;
+            if (m_is_visited[neighbor_id] || m_position[neighbor_id] > upper_position)
+                continue;
+            m_is_visited[neighbor_id] = true;
+            classes.push_back(neighbor_id);
+            stack.push_back(neighbor_id);
+        }
+    }
+    return true;
+}
+
+// the classes that reach class_id after lower_position
+void AxisOrdering::collect_backward(
+    size_t class_id, size_t lower_position, std::vector<size_t>& classes
+) {
+    std::vector<size_t> stack{class_id};
+    m_is_visited[class_id] = true;
+    classes.push_back(class_id);
+    while (!stack.empty()) {
+        const size_t current = stack.back();
+        stack.pop_back();
+        for (const auto [edge_id, neighbor_id] : m_ordering.get_in_edges(current)) {
+            if (m_is_set_aside[edge_id])
+                continue;
+            if (m_is_visited[neighbor_id] || m_position[neighbor_id] < lower_position)
+                continue;
+            m_is_visited[neighbor_id] = true;
+            classes.push_back(neighbor_id);
+            stack.push_back(neighbor_id);
+        }
+    }
+}
+
+// only the classes between the ends of the edge are visited, those reachable from its end move
+// after those reaching its start, reusing the same positions
+void AxisOrdering::insert_ordering_edge(size_t ordering_edge_id) {
+    const auto [class_from, class_to] = m_ordering.get_edge(ordering_edge_id);
+    const size_t lower_position = m_position[class_to];
+    const size_t upper_position = m_position[class_from];
+    if (upper_position < lower_position) {
+        m_is_set_aside[ordering_edge_id] = false;
+        return;
+    }
+    std::vector<size_t> forward;
+    std::vector<size_t> backward;
+    const bool is_acyclic = collect_forward(class_to, upper_position, forward);
+    if (is_acyclic)
+        collect_backward(class_from, lower_position, backward);
+    for (size_t class_id : forward)
+        m_is_visited[class_id] = false;
+    for (size_t class_id : backward)
+        m_is_visited[class_id] = false;
+    if (!is_acyclic) {
+        m_is_set_aside[ordering_edge_id] = true;
+        m_set_aside_edges.push_back(ordering_edge_id);
+        return;
+    }
+    m_is_set_aside[ordering_edge_id] = false;
+    auto by_position = [&](size_t class_1, size_t class_2) {
+        return m_position[class_1] < m_position[class_2];
+    };
+    std::ranges::sort(forward, by_position);
+    std::ranges::sort(backward, by_position);
+    std::vector<size_t> positions;
+    for (size_t class_id : backward)
+        positions.push_back(m_position[class_id]);
+    for (size_t class_id : forward)
+        positions.push_back(m_position[class_id]);
+    std::ranges::sort(positions);
+    size_t index = 0;
+    for (const std::vector<size_t>* classes : {&backward, &forward})
+        for (size_t class_id : *classes) {
+            m_position[class_id] = positions[index++];
+            m_class_at[m_position[class_id]] = class_id;
+        }
+}
+
+// a set aside edge may stop closing a cycle only when some other edge is removed
+void AxisOrdering::retry_set_aside_edges() {
+    if (!m_has_removed_edges)
+        return;
+    m_has_removed_edges = false;
+    // they stay marked (out of the order) until retried
+    const std::vector<size_t> set_aside_edges = std::move(m_set_aside_edges);
+    m_set_aside_edges.clear();
+    for (size_t ordering_edge_id : set_aside_edges)
+        insert_ordering_edge(ordering_edge_id);
+}
+
+void AxisOrdering::compute_order() {
+    enum class State { NEW, OPEN, CLOSED };
+    std::vector<State> states(m_ordering.get_number_of_nodes(), State::NEW);
+    std::vector<size_t> closed;
+    std::vector<std::pair<size_t, size_t>> stack; // class and index of its next out edge
+    for (size_t root : m_ordering.get_node_ids()) {
+        if (states[root] != State::NEW)
+            continue;
+        states[root] = State::OPEN;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [class_id, index] = stack.back();
+            const auto out_edges = m_ordering.get_out_edges(class_id);
+            if (index == out_edges.size()) {
+                states[class_id] = State::CLOSED;
+                closed.push_back(class_id);
+                stack.pop_back();
+                continue;
+            }
+            const auto [edge_id, neighbor_id] = out_edges[static_cast<std::ptrdiff_t>(index++)];
+            if (states[neighbor_id] == State::OPEN) {
+                m_is_set_aside[edge_id] = true;
+                m_set_aside_edges.push_back(edge_id);
+            } else if (states[neighbor_id] == State::NEW) {
+                states[neighbor_id] = State::OPEN;
+                stack.emplace_back(neighbor_id, 0);
+            }
+        }
+    }
+    for (size_t position = 0; position < closed.size(); ++position) {
+        const size_t class_id = closed[closed.size() - 1 - position];
+        m_position[class_id] = position;
+        m_class_at[position] = class_id;
+    }
+}
+
+const EquivalenceClasses& AxisOrdering::get_classes() const { return m_classes; }
+
+const Graph& AxisOrdering::get_ordering() const { return m_ordering; }
+
+const EdgesLabels& AxisOrdering::get_ordering_edge_to_graph_edge() const {
+    return m_ordering_edge_to_graph_edge;
+}
+
+bool AxisOrdering::has_cycle() const { return !m_set_aside_edges.empty(); }
+
+std::optional<Cycle> AxisOrdering::find_cycle() const {
+    if (!has_cycle())
+        return std::nullopt;
+    const size_t set_aside_edge_id = m_set_aside_edges.front();
+    const auto [class_from, class_to] = m_ordering.get_edge(set_aside_edge_id);
+    // the edges in the order always lead from class_to back to class_from
+    std::vector<std::optional<size_t>> parent_edge(m_ordering.get_number_of_nodes());
+    std::queue<size_t> queue;
+    queue.push(class_to);
+    while (!queue.empty() && !parent_edge[class_from].has_value()) {
+        const size_t class_id = queue.front();
+        queue.pop();
+        for (const auto [edge_id, neighbor_id] : m_ordering.get_out_edges(class_id)) {
+            if (m_is_set_aside[edge_id] || neighbor_id == class_to ||
+                parent_edge[neighbor_id].has_value())
+                continue;
+            parent_edge[neighbor_id] = edge_id;
+            queue.push(neighbor_id);
+        }
+    }
+    DOMUS_ASSERT(
+        parent_edge[class_from].has_value(),
+        "AxisOrdering::find_cycle: set aside edge does not close a cycle"
+    );
+    std::vector<size_t> edges;
+    for (size_t current = class_from; current != class_to;) {
+        edges.push_back(*parent_edge[current]);
+        current = m_ordering.get_edge(*parent_edge[current]).from_id;
+    }
+    Path path;
+    path.push_back(m_ordering, class_from, set_aside_edge_id);
+    size_t prev_id = class_to;
+    for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+        path.push_back(m_ordering, prev_id, *it);
+        prev_id = m_ordering.get_edge(*it).to_id;
+    }
+    return Cycle(path);
+}
+
+IncrementalOrdering::IncrementalOrdering(const Graph& graph, const Shape& shape)
+    : m_ordering_x(graph, true), m_ordering_y(graph, false) {
+    update(graph, shape);
+}
+
+std::optional<Direction> get_direction_if_any(const Shape& shape, size_t edge_id) {
+    if (!shape.contains(edge_id))
+        return std::nullopt;
+    return shape.get_direction(edge_id);
+}
+
+void IncrementalOrdering::update(const Graph& graph, const Shape& shape) {
+    std::vector<size_t> edge_ids;
+    for (size_t edge_id = 0; edge_id < m_edges.size(); ++edge_id)
+        if (m_edges[edge_id].has_value() && !graph.has_edge_id(edge_id))
+            edge_ids.push_back(edge_id);
+    for (size_t node_id : graph.get_node_ids())
+        for (const auto [edge_id, neighbor_id] : graph.get_out_edges(node_id)) {
+            const bool is_unchanged = edge_id < m_edges.size() && m_edges[edge_id].has_value() &&
+                                      m_edges[edge_id]->edge == Edge{node_id, neighbor_id} &&
+                                      m_edges[edge_id]->direction ==
+                                          get_direction_if_any(shape, edge_id);
+            if (!is_unchanged)
+                edge_ids.push_back(edge_id);
+        }
+    update(graph, shape, edge_ids);
+}
+
+void IncrementalOrdering::update(
+    const Graph& graph, const Shape& shape, std::span<const size_t> edge_ids
+) {
+    std::vector<size_t> touched_node_ids;
+    for (size_t node_id = m_number_of_nodes; node_id < graph.get_number_of_nodes(); ++node_id)
+        touched_node_ids.push_back(node_id);
+    m_number_of_nodes = graph.get_number_of_nodes();
+    for (size_t edge_id : edge_ids) {
+        if (m_edges.size() <= edge_id)
+            m_edges.resize(edge_id + 1);
+        if (m_edges[edge_id].has_value()) {
+            touched_node_ids.push_back(m_edges[edge_id]->edge.from_id);
+            touched_node_ids.push_back(m_edges[edge_id]->edge.to_id);
+        }
+        if (!graph.has_edge_id(edge_id)) {
+            m_edges[edge_id].reset();
+            continue;
+        }
+        const Edge edge = graph.get_edge(edge_id);
+        touched_node_ids.push_back(edge.from_id);
+        touched_node_ids.push_back(edge.to_id);
+        m_edges[edge_id] = EdgeState{edge, get_direction_if_any(shape, edge_id)};
+    }
+    m_ordering_x.update(graph, shape, edge_ids, touched_node_ids);
+    m_ordering_y.update(graph, shape, edge_ids, touched_node_ids);
+}
+
+const AxisOrdering& IncrementalOrdering::get_ordering_x() const { return m_ordering_x; }
+
+const AxisOrdering& IncrementalOrdering::get_ordering_y() const { return m_ordering_y; }
+
+} // namespace domus::orthogonal
\ No newline at end of file
@@ -23,6 +23,21 @@ save_shape_metrics_drawing_to_file(const ShapeMetricsDrawing& result, std::files
     data["initial_number_of_cycles"] = result.initial_number_of_cycles;
     data["number_of_added_cycles"] = result.number_of_added_cycles;
     data["number_of_useless_bends"] = result.number_of_useless_bends;
+    const sat::SatSolverStats& stats = result.sat_stats;
+    data["sat_stats"] = {
+        {"number_of_solves", stats.number_of_solves},
+        {"conflicts", stats.conflicts},
+        {"decisions", stats.decisions},
+        {"propagations", stats.propagations},
+        {"restarts", stats.restarts},
+        {"learned_clauses", stats.learned_clauses},
+        {"peak_memory_mb", stats.peak_memory_mb},
+        {"wall_time_ms", stats.wall_time_ms}
+    };
+    data["split_stats"] = {
+        {"number_of_rounds", result.split_stats.number_of_rounds},
+        {"number_of_split_edges", result.split_stats.number_of_split_edges}
+    };
     std::ofstream file(path);
     if (!file.is_open())
         return std::unexpected(
@@ -49,6 +64,22 @@ load_shape_metrics_drawing_from_file(std::filesystem::path path) {
         static_cast<size_t>(data.value("initial_number_of_cycles", 0));
     result.number_of_added_cycles = static_cast<size_t>(data.value("number_of_added_cycles", 0));
     result.number_of_useless_bends = static_cast<size_t>(data.value("number_of_useless_bends", 0));
+    if (data.contains("sat_stats")) {
+        const json& stats = data["sat_stats"];
+        result.sat_stats.number_of_solves = stats.value("number_of_solves", size_t{0});
+        result.sat_stats.conflicts = stats.value("conflicts", uint64_t{0});
+        result.sat_stats.decisions = stats.value("decisions", uint64_t{0});
+        result.sat_stats.propagations = stats.value("propagations", uint64_t{0});
+        result.sat_stats.restarts = stats.value("restarts", uint64_t{0});
+        result.sat_stats.learned_clauses = stats.value("learned_clauses", uint64_t{0});
+        result.sat_stats.peak_memory_mb = stats.value("peak_memory_mb", 0.0);
+        result.sat_stats.wall_time_ms = stats.value("wall_time_ms", 0.0);
+    }
+    if (data.contains("split_stats")) {
+        const json& stats = data["split_stats"];
+        result.split_stats.number_of_rounds = stats.value("number_of_rounds", size_t{0});
+        result.split_stats.number_of_split_edges = stats.value("number_of_split_edges", size_t{0});
+    }
     return result;
 }
 
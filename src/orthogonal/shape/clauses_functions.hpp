@@ -1,52 +1,329 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 
-namespace domus::sat::cnf {
-class Cnf;
-}
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+#include "domus/orthogonal/shape/direction.hpp"
+#include "domus/sat/clause_sink.hpp"
+
+#include "../../core/domus_debug.hpp"
+#include "variables_handler.hpp"
 
-namespace domus::graph {
-class Cycle;
-class Graph;
-} // namespace domus::graph
+// the functions are templates on the clause sink, so that the clauses are written
+// straight into the destination (a solver, a Cnf, a counter) without copies
 
 namespace domus::orthogonal::shape {
-enum class Direction;
-class VariablesHandler;
 
-// each edge can only be in one direction
-void add_constraints_one_direction_per_edge(
-    const graph::Graph& graph, sat::cnf::Cnf& cnf_builder, const VariablesHandler& handler
+// literals of the direction of the edge going from node to neighbor
+DirectionLiterals get_direction_literals(
+    const graph::Graph& graph,
+    const VariablesHandler& handler,
+    size_t node_id,
+    size_t neighbor_id,
+    size_t edge_id,
+    Direction direction
 );
 
+struct EdgeDirection {
+    size_t edge_id;
+    DirectionLiterals literals;
+};
+
+// the clauses of the nodes of degree at most 4 and of the edges follow a few fixed patterns,
+// computed at compile time: the literals of the edges are substituted into the positions of
+// the pattern and each clause is written from the stack, without allocations
+inline constexpr size_t MAX_TEMPLATE_DEGREE = 4;
+
+struct PositionPair {
+    uint8_t first;
+    uint8_t second;
+};
+
+// the pairs (i, j) with i < j < degree, in the order of two nested loops
+struct PairsTemplate {
+    std::array<PositionPair, MAX_TEMPLATE_DEGREE * (MAX_TEMPLATE_DEGREE - 1) / 2> pairs{};
+    size_t size = 0;
+};
+
+constexpr std::array<PairsTemplate, MAX_TEMPLATE_DEGREE + 1> make_pairs_templates() {
+    std::array<PairsTemplate, MAX_TEMPLATE_DEGREE + 1> templates{};
+    for (uint8_t degree = 0; degree <= MAX_TEMPLATE_DEGREE; ++degree)
+        for (uint8_t i = 0; i < degree; ++i)
+            for (uint8_t j = i + 1; j < degree; ++j)
+                templates[degree].pairs[templates[degree].size++] = {i, j};
+    return templates;
+}
+
+// indexed by degree
+inline constexpr std::array<PairsTemplate, MAX_TEMPLATE_DEGREE + 1> PAIRS_TEMPLATES =
+    make_pairs_templates();
+static_assert(PAIRS_TEMPLATES[2].size == 1 && PAIRS_TEMPLATES[4].size == 6);
+
+// what a node of degree at most 4 requires in each direction
+enum class NodeTemplate {
+    NONE, // degree 0 and 1: a single edge is free
+    AT_MOST_ONE, // the pairs of PAIRS_TEMPLATES
+    // degree 4 with one literal per direction: the four edges take the four directions,
+    // at most one per direction is the same as at least one, with a single clause
+    AT_LEAST_ONE,
+};
+
+constexpr std::array<NodeTemplate, MAX_TEMPLATE_DEGREE + 1> make_node_templates() {
+    return {
+        NodeTemplate::NONE,
+        NodeTemplate::NONE,
+        NodeTemplate::AT_MOST_ONE,
+        NodeTemplate::AT_MOST_ONE,
+        LITERALS_PER_DIRECTION == 1 ? NodeTemplate::AT_LEAST_ONE : NodeTemplate::AT_MOST_ONE,
+    };
+}
+
+// indexed by degree, the same in all four directions
+inline constexpr std::array<NodeTemplate, MAX_TEMPLATE_DEGREE + 1> NODE_TEMPLATES =
+    make_node_templates();
+
+// the direction of an edge seen from its to node, indexed by its direction from its from node
+inline constexpr std::array<Direction, 4> OPPOSITE_DIRECTIONS = {
+    Direction::RIGHT, Direction::LEFT, Direction::DOWN, Direction::UP
+};
+
+// for every pair of literals, at least one of them is false
+template <sat::ClauseSink Sink>
+void add_at_most_one_clauses(Sink& sink, std::span<const DirectionLiterals> directions) {
+    DOMUS_ASSERT(
+        directions.size() <= MAX_TEMPLATE_DEGREE, "add_at_most_one_clauses: too many directions"
+    );
+    const PairsTemplate& pairs = PAIRS_TEMPLATES[directions.size()];
+    std::array<int, 2 * LITERALS_PER_DIRECTION> clause;
+    for (size_t p = 0; p < pairs.size; ++p) {
+        const auto [i, j] = pairs.pairs[p];
+        for (size_t k = 0; k < LITERALS_PER_DIRECTION; ++k) {
+            clause[k] = -directions[i][k];
+            clause[LITERALS_PER_DIRECTION + k] = -directions[j][k];
+        }
+        sink.add_clause(clause);
+    }
+}
+
+// at least one of the edges is in its direction; a direction made of more than one literal
+// gets a witness variable that implies all of its literals
+template <sat::ClauseSink Sink>
+void add_at_least_one_clause(
+    Sink& sink, VariablesHandler& handler, const std::vector<EdgeDirection>& directions
+) {
+    std::vector<int> clause;
+    for (const auto& [edge_id, literals] : directions) {
+        if constexpr (LITERALS_PER_DIRECTION == 1) {
+            clause.push_back(literals[0]);
+        } else {
+            const int witness = static_cast<int>(handler.add_edge_auxiliary_variable(edge_id));
+            sink.reserve_variables(static_cast<size_t>(witness));
+            for (int literal : literals)
+                sat::add_clause(sink, {-witness, literal});
+            clause.push_back(witness);
+        }
+    }
+    sink.add_clause(clause);
+}
+
+// each edge can only be in one direction, with the compact encoding every assignment of the
+// variables of the edge is a direction and no clause is needed
+template <sat::ClauseSink Sink>
+void add_constraints_one_direction_per_edge(
+    Sink& sink, const VariablesHandler& handler, size_t edge_id
+) {
+    if constexpr (LITERALS_PER_DIRECTION == 1) {
+        int up = handler.get_direction_literals(edge_id, Direction::UP)[0];
+        int down = handler.get_direction_literals(edge_id, Direction::DOWN)[0];
+        int right = handler.get_direction_literals(edge_id, Direction::RIGHT)[0];
+        int left = handler.get_direction_literals(edge_id, Direction::LEFT)[0];
+        sat::add_clause(sink, {up, down, right, left}); // at least one is true
+        // at most one is true (at least three are false)
+        const std::array<DirectionLiterals, 4> directions = {{{up}, {down}, {left}, {right}}};
+        add_at_most_one_clauses(sink, directions);
+    }
+}
+
+template <sat::ClauseSink Sink>
+void add_constraints_one_direction_per_edge(
+    const graph::Graph& graph, Sink& sink, const VariablesHandler& handler
+) {
+    sink.reserve_variables(handler.get_number_of_variables());
+    graph.for_each_node([&](size_t node_id_1) {
+        graph.for_each_out_edge(node_id_1, [&](size_t edge_id, size_t) {
+            add_constraints_one_direction_per_edge(sink, handler, edge_id);
+        });
+    });
+}
+
+inline std::vector<EdgeDirection> get_edges_directions(
+    const graph::Graph& graph,
+    const VariablesHandler& handler,
+    size_t node_id,
+    Direction direction
+) {
+    std::vector<EdgeDirection> directions;
+    graph.for_each_edge(node_id, [&](size_t edge_id, size_t neighbor_id) {
+        directions.push_back(
+            {edge_id,
+             get_direction_literals(graph, handler, node_id, neighbor_id, edge_id, direction)}
+        );
+    });
+    return directions;
+}
+
 // at least one neighbor of node is in the direction
+template <sat::ClauseSink Sink>
 void add_clause_at_least_one_in_direction(
     const graph::Graph& graph,
-    sat::cnf::Cnf& cnf_builder,
-    const VariablesHandler& handler,
+    Sink& sink,
+    VariablesHandler& handler,
     size_t node_id,
     Direction direction
-);
+) {
+    add_at_least_one_clause(
+        sink, handler, get_edges_directions(graph, handler, node_id, direction)
+    );
+}
+
+// the edges of a node of degree at most 4, in the order of for_each_edge
+struct NodeEdges {
+    std::array<size_t, MAX_TEMPLATE_DEGREE> edge_ids;
+    // the node is the to node of the edge
+    std::array<bool, MAX_TEMPLATE_DEGREE> is_incoming;
+    size_t degree = 0;
+};
 
-// no two neighbors of node can be in the same direction
+inline NodeEdges get_node_edges(const graph::Graph& graph, size_t node_id) {
+    NodeEdges edges;
+    for (const auto [edge_id, neighbor_id] : graph.get_in_edges(node_id)) {
+        edges.edge_ids[edges.degree] = edge_id;
+        edges.is_incoming[edges.degree++] = true;
+    }
+    for (const auto [edge_id, neighbor_id] : graph.get_out_edges(node_id)) {
+        edges.edge_ids[edges.degree] = edge_id;
+        edges.is_incoming[edges.degree++] = false;
+    }
+    return edges;
+}
+
+// no two neighbors of the node can be in the same direction
+template <sat::ClauseSink Sink>
 void add_one_edge_per_direction_clauses(
-    const graph::Graph& graph,
-    sat::cnf::Cnf& cnf_builder,
-    const VariablesHandler& handler,
-    Direction direction,
-    size_t node_id
-);
+    Sink& sink, const VariablesHandler& handler, const NodeEdges& edges, Direction direction
+) {
+    const NodeTemplate node_template = NODE_TEMPLATES[edges.degree];
+    if (node_template == NodeTemplate::NONE)
+        return;
+    const Direction opposite = OPPOSITE_DIRECTIONS[static_cast<size_t>(direction)];
+    std::array<DirectionLiterals, MAX_TEMPLATE_DEGREE> literals;
+    for (size_t i = 0; i < edges.degree; ++i)
+        literals[i] = handler.get_direction_literals(
+            edges.edge_ids[i], edges.is_incoming[i] ? opposite : direction
+        );
+    if (node_template == NodeTemplate::AT_MOST_ONE) {
+        add_at_most_one_clauses(sink, std::span(literals.data(), edges.degree));
+        return;
+    }
+    std::array<int, MAX_TEMPLATE_DEGREE> clause;
+    for (size_t i = 0; i < MAX_TEMPLATE_DEGREE; ++i)
+        clause[i] = literals[i][0];
+    sink.add_clause(clause);
+}
 
-void add_nodes_constraints(
-    const graph::Graph& graph, sat::cnf::Cnf& cnf_builder, const VariablesHandler& handler
-);
+template <sat::ClauseSink Sink>
+void add_node_constraints(
+    const graph::Graph& graph, Sink& sink, VariablesHandler& handler, size_t node_id
+) {
+    if (graph.get_degree_of_node(node_id) <= MAX_TEMPLATE_DEGREE) {
+        const NodeEdges edges = get_node_edges(graph, node_id);
+        for (Direction direction :
+             {Direction::UP, Direction::DOWN, Direction::RIGHT, Direction::LEFT})
+            add_one_edge_per_direction_clauses(sink, handler, edges, direction);
+    } else {
+        add_clause_at_least_one_in_direction(graph, sink, handler, node_id, Direction::UP);
+        add_clause_at_least_one_in_direction(graph, sink, handler, node_id, Direction::DOWN);
+        add_clause_at_least_one_in_direction(graph, sink, handler, node_id, Direction::RIGHT);
+        add_clause_at_least_one_in_direction(graph, sink, handler, node_id, Direction::LEFT);
+    }
+}
+
+template <sat::ClauseSink Sink>
+void add_nodes_constraints(const graph::Graph& graph, Sink& sink, VariablesHandler& handler) {
+    graph.for_each_node([&](size_t node_id) {
+        add_node_constraints(graph, sink, handler, node_id);
+    });
+}
 
+// the edges of the cycle must point in all four directions
+template <sat::ClauseSink Sink>
+void add_cycle_constraints(
+    const graph::Graph& graph, Sink& sink, const graph::Cycle& cycle, VariablesHandler& handler
+) {
+    std::vector<EdgeDirection> at_least_one_down{};
+    std::vector<EdgeDirection> at_least_one_up{};
+    std::vector<EdgeDirection> at_least_one_right{};
+    std::vector<EdgeDirection> at_least_one_left{};
+    for (size_t i = 0; i < cycle.size(); i++) {
+        size_t cycle_node = cycle.node_id_at(i);
+        size_t next_cycle_node = cycle.node_id_at(i + 1);
+        size_t edge_id = cycle.edge_id_at(i);
+        DOMUS_ASSERT(
+            graph.are_neighbors(cycle_node, next_cycle_node),
+            "add_cycles_constraints: cycle nodes are not neighbors"
+        );
+        auto direction_of = [&](Direction direction) {
+            return EdgeDirection{
+                edge_id,
+                get_direction_literals(
+                    graph, handler, cycle_node, next_cycle_node, edge_id, direction
+                )
+            };
+        };
+        at_least_one_down.push_back(direction_of(Direction::DOWN));
+        at_least_one_up.push_back(direction_of(Direction::UP));
+        at_least_one_right.push_back(direction_of(Direction::RIGHT));
+        at_least_one_left.push_back(direction_of(Direction::LEFT));
+    }
+    add_at_least_one_clause(sink, handler, at_least_one_down);
+    add_at_least_one_clause(sink, handler, at_least_one_up);
+    add_at_least_one_clause(sink, handler, at_least_one_right);
+    add_at_least_one_clause(sink, handler, at_least_one_left);
+}
+
+// two edges sharing a node, std::nullopt if there are none
+std::optional<std::pair<size_t, size_t>> find_symmetry_breaking_edges(const graph::Graph& graph);
+
+// a shape rotated by 90 degrees or mirrored is still a shape: rotating, any shape has a copy in
+// which edge_id is RIGHT and then, mirroring along edge_id, a copy in which other_edge_id is not
+// DOWN; the two edges must have exactly one direction each
+template <sat::ClauseSink Sink>
+void add_symmetry_breaking_clauses(
+    Sink& sink, const VariablesHandler& handler, size_t edge_id, size_t other_edge_id
+) {
+    for (int literal : handler.get_direction_literals(edge_id, Direction::RIGHT))
+        sat::add_clause(sink, {literal});
+    DirectionLiterals not_down = handler.get_direction_literals(other_edge_id, Direction::DOWN);
+    for (int& literal : not_down)
+        literal = -literal;
+    sink.add_clause(not_down);
+}
+
+template <sat::ClauseSink Sink>
 void add_cycles_constraints(
     const graph::Graph& graph,
-    sat::cnf::Cnf& cnf_builder,
+    Sink& sink,
     const std::vector<graph::Cycle>& cycles,
-    const VariablesHandler& handler
-);
+    VariablesHandler& handler
+) {
+    for (const graph::Cycle& cycle : cycles)
+        add_cycle_constraints(graph, sink, cycle, handler);
+}
 
 } // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "cnf_dumper.hpp"
+
+#include <format>
+#include <system_error>
+#include <utility>
+
+#include "domus/core/graph/graph.hpp"
+#include "domus/sat/cnf.hpp"
+
+namespace domus::orthogonal::shape {
+using namespace sat;
+
+CnfDumper::CnfDumper(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+std::expected<void, std::string> CnfDumper::dump(
+    const cnf::Cnf& cnf,
+    std::span<const int> assumptions,
+    const graph::Graph& graph,
+    size_t number_of_cycles,
+    size_t iteration,
+    SatSolverResultType result
+) {
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+        return std::unexpected(std::format(
+            "CnfDumper::dump: could not create directory {}: {}",
+            m_directory.string(),
+            error.message()
+        ));
+    cnf::Cnf dumped;
+    dumped.add_comment(std::format("domus iteration {}", iteration));
+    dumped.add_comment(std::format(
+        "domus nodes {} edges {} cycles {}",
+        graph.get_number_of_nodes(),
+        graph.get_number_of_edges(),
+        number_of_cycles
+    ));
+    dumped.add_comment(std::format("domus result {}", sat_solver_result_type_to_string(result)));
+    dumped.reserve_variables(cnf.get_number_of_variables());
+    for (std::span<const int> clause : cnf.get_clauses())
+        dumped.add_clause(clause);
+    if (!assumptions.empty())
+        dumped.add_comment("domus assumptions");
+    for (int assumption : assumptions)
+        dumped.add_clause({assumption});
+    const std::filesystem::path path = m_directory / std::format("{:06}.cnf", m_number_of_dumps++);
+    return dumped.save_to_file(path.string());
+}
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+
+#include "domus/sat/sat.hpp"
+
+namespace domus::graph {
+class Graph;
+}
+
+namespace domus::sat::cnf {
+class Cnf;
+}
+
+namespace domus::orthogonal::shape {
+
+// writes the formulas of the SAT calls of a run to a directory in DIMACS format, one file
+// per call (000000.cnf, 000001.cnf, ...) with the assumptions as unit clauses and comments
+// with the size of the graph, the iteration and the result, to replay them offline
+class CnfDumper {
+    std::filesystem::path m_directory;
+    size_t m_number_of_dumps = 0;
+
+  public:
+    explicit CnfDumper(std::filesystem::path directory);
+    std::expected<void, std::string> dump(
+        const sat::cnf::Cnf& cnf,
+        std::span<const int> assumptions,
+        const graph::Graph& graph,
+        size_t number_of_cycles,
+        size_t iteration,
+        sat::SatSolverResultType result
+    );
+};
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
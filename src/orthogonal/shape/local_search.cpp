@@ -0,0 +1,224 @@
+#include "local_search.hpp"
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+
+namespace domus::orthogonal::shape {
+using namespace graph;
+
+// probability of a random move instead of the best one
+constexpr double LOCAL_SEARCH_NOISE = 0.2;
+
+constexpr size_t NOT_VIOLATED = std::numeric_limits<size_t>::max();
+
+size_t direction_index(Direction direction) { return static_cast<size_t>(direction); }
+
+using DirectionCounts = std::array<size_t, 4>;
+
+// the constraints are the nodes (ids 0 to number of nodes - 1) followed by the cycles,
+// their costs are kept up to date from the number of edges in each direction
+class ShapeLocalSearch {
+    struct EdgeEnds {
+        size_t edge_id;
+        size_t from_id;
+        size_t to_id;
+    };
+    struct CycleOccurrence {
+        size_t cycle_index;
+        bool is_reversed;
+    };
+    const Graph& m_graph;
+    const std::vector<Cycle>& m_cycles;
+    std::mt19937& m_random_engine;
+    std::vector<EdgeEnds> m_edges;
+    std::vector<size_t> m_edge_index;
+    std::vector<std::vector<CycleOccurrence>> m_edge_cycles;
+    // direction of each edge from its from node to its to node
+    std::vector<Direction> m_directions;
+    std::vector<DirectionCounts> m_node_counts;
+    std::vector<DirectionCounts> m_cycle_counts;
+    std::vector<size_t> m_costs;
+    size_t m_total_cost = 0;
+    std::vector<size_t> m_violated;
+    std::vector<size_t> m_violated_position;
+
+    // a node of degree at most 4 has at most one edge per direction,
+    // a larger node and a cycle have at least one edge per direction
+    size_t compute_cost(size_t constraint) const {
+        size_t cost = 0;
+        if (constraint < m_node_counts.size() && m_graph.get_degree_of_node(constraint) <= 4) {
+            for (size_t count : m_node_counts[constraint])
+                cost += count > 1 ? count - 1 : 0;
+            return cost;
+        }
+        const DirectionCounts& counts = constraint < m_node_counts.size()
+                                            ? m_node_counts[constraint]
+                                            : m_cycle_counts[constraint - m_node_counts.size()];
+        for (size_t count : counts)
+            cost += count == 0 ? 1 : 0;
+        return cost;
+    }
+
+    void update_constraint(size_t constraint) {
+        const size_t cost = compute_cost(constraint);
+        m_total_cost = m_total_cost - m_costs[constraint] + cost;
+        m_costs[constraint] = cost;
+        const bool was_violated = m_violated_position[constraint] != NOT_VIOLATED;
+        if (cost > 0 && !was_violated) {
+            m_violated_position[constraint] = m_violated.size();
+            m_violated.push_back(constraint);
+        } else if (cost == 0 && was_violated) {
+            const size_t position = m_violated_position[constraint];
+            m_violated[position] = m_violated.back();
+            m_violated_position[m_violated[position]] = position;
+            m_violated.pop_back();
+            m_violated_position[constraint] = NOT_VIOLATED;
+        }
+    }
+
+    void add_to_counts(size_t index, Direction direction, int sign) {
+        auto add = [sign](size_t& counter) {
+            counter = sign > 0 ? counter + 1 : counter - 1;
+        };
+        const EdgeEnds& edge = m_edges[index];
+        const Direction opposite = opposite_direction(direction);
+        add(m_node_counts[edge.from_id][direction_index(direction)]);
+        add(m_node_counts[edge.to_id][direction_index(opposite)]);
+        for (const auto [cycle_index, is_reversed] : m_edge_cycles[index])
+            add(m_cycle_counts[cycle_index][direction_index(is_reversed ? opposite : direction)]);
+    }
+
+    void set_direction(size_t index, Direction direction) {
+        add_to_counts(index, m_directions[index], -1);
+        m_directions[index] = direction;
+        add_to_counts(index, direction, +1);
+        const EdgeEnds& edge = m_edges[index];
+        update_constraint(edge.from_id);
+        update_constraint(edge.to_id);
+        for (const CycleOccurrence& occurrence : m_edge_cycles[index])
+            update_constraint(m_node_counts.size() + occurrence.cycle_index);
+    }
+
+    std::vector<size_t> get_edges_of_constraint(size_t constraint) const {
+        std::vector<size_t> edges;
+        if (constraint < m_node_counts.size())
+            m_graph.for_each_edge(constraint, [&](size_t edge_id, size_t) {
+                edges.push_back(m_edge_index[edge_id]);
+            });
+        else {
+            const Cycle& cycle = m_cycles[constraint - m_node_counts.size()];
+            for (size_t i = 0; i < cycle.size(); ++i)
+                edges.push_back(m_edge_index[cycle.edge_id_at(i)]);
+        }
+        return edges;
+    }
+
+    // a random move with probability LOCAL_SEARCH_NOISE, otherwise the move that leaves the
+    // fewest violations (ties broken at random); the moves change the direction of an edge
+    // of a violated constraint
+    void flip() {
+        const size_t constraint = m_violated[m_random_engine() % m_violated.size()];
+        const std::vector<size_t> edges = get_edges_of_constraint(constraint);
+        std::vector<std::pair<size_t, Direction>> moves;
+        for (size_t index : edges)
+            for (Direction direction : get_all_directions())
+                if (direction != m_directions[index])
+                    moves.emplace_back(index, direction);
+        if (std::uniform_real_distribution<double>(0.0, 1.0)(m_random_engine) <
+            LOCAL_SEARCH_NOISE) {
+            const auto [index, direction] = moves[m_random_engine() % moves.size()];
+            set_direction(index, direction);
+            return;
+        }
+        size_t best_cost = std::numeric_limits<size_t>::max();
+        size_t number_of_best = 0;
+        std::pair<size_t, Direction> best_move = moves[0];
+        for (const auto& [index, direction] : moves) {
+            const Direction current = m_directions[index];
+            set_direction(index, direction);
+            const size_t cost = m_total_cost;
+            set_direction(index, current);
+            if (cost < best_cost) {
+                best_cost = cost;
+                number_of_best = 0;
+            }
+            if (cost == best_cost && m_random_engine() % ++number_of_best == 0)
+                best_move = {index, direction};
+        }
+        set_direction(best_move.first, best_move.second);
+    }
+
+  public:
+    ShapeLocalSearch(
+        const Graph& graph,
+        const std::vector<Cycle>& cycles,
+        const Shape& initial,
+        std::mt19937& random_engine
+    )
+        : m_graph(graph), m_cycles(cycles), m_random_engine(random_engine) {
+        graph.for_each_node([&](size_t node_id) {
+            graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t neighbor_id) {
+                if (m_edge_index.size() <= edge_id)
+                    m_edge_index.resize(edge_id + 1);
+                m_edge_index[edge_id] = m_edges.size();
+                m_edges.push_back({edge_id, node_id, neighbor_id});
+                const Direction direction =
+                    initial.contains(edge_id)
+                        ? initial.get_direction(edge_id)
+                        : get_all_directions()[m_random_engine() % get_all_directions().size()];
+                m_directions.push_back(direction);
+            });
+        });
+        m_edge_cycles.resize(m_edges.size());
+        for (size_t cycle_index = 0; cycle_index < cycles.size(); ++cycle_index) {
+            const Cycle& cycle = cycles[cycle_index];
+            for (size_t i = 0; i < cycle.size(); ++i) {
+                const size_t index = m_edge_index[cycle.edge_id_at(i)];
+                const bool is_reversed = m_edges[index].from_id != cycle.node_id_at(i);
+                m_edge_cycles[index].push_back({cycle_index, is_reversed});
+            }
+        }
+        m_node_counts.resize(graph.get_number_of_nodes(), DirectionCounts{});
+        m_cycle_counts.resize(cycles.size(), DirectionCounts{});
+        for (size_t index = 0; index < m_edges.size(); ++index)
+            add_to_counts(index, m_directions[index], +1);
+        const size_t number_of_constraints = m_node_counts.size() + m_cycle_counts.size();
+        m_costs.resize(number_of_constraints, 0);
+        m_violated_position.resize(number_of_constraints, NOT_VIOLATED);
+        for (size_t constraint = 0; constraint < number_of_constraints; ++constraint)
+            update_constraint(constraint);
+    }
+
+    std::optional<Shape> run(size_t max_flips) {
+        for (size_t flips = 0; !m_violated.empty(); ++flips) {
+            if (flips == max_flips)
+                return std::nullopt;
+            flip();
+        }
+        Shape shape;
+        for (size_t index = 0; index < m_edges.size(); ++index)
+            shape.set_direction(m_edges[index].edge_id, m_directions[index]);
+        return shape;
+    }
+};
+
+std::optional<Shape> find_shape_with_local_search(
+    const Graph& graph,
+    const std::vector<Cycle>& cycles,
+    const Shape& initial,
+    size_t max_flips,
+    std::mt19937& random_engine
+) {
+    ShapeLocalSearch search(graph, cycles, initial, random_engine);
+    return search.run(max_flips);
+}
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "domus/orthogonal/shape/shape.hpp"
+
+namespace domus::graph {
+class Cycle;
+class Graph;
+} // namespace domus::graph
+
+namespace domus::orthogonal::shape {
+
+// stochastic local search on the directions of the edges (walksat on the node and cycle
+// constraints of the shape formula, without the symmetry breaking ones): the edges missing
+// from initial get a random direction, std::nullopt if some constraint is still violated
+// after max_flips changes of direction
+std::optional<Shape> find_shape_with_local_search(
+    const graph::Graph& graph,
+    const std::vector<graph::Cycle>& cycles,
+    const Shape& initial,
+    size_t max_flips,
+    std::mt19937& random_engine
+);
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
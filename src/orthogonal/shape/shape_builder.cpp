@@ -1,22 +1,27 @@
 #include "domus/orthogonal/shape/shape_builder.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
-#include <cstdlib>
+#include <cstdint>
+#include <format>
 #include <optional>
 #include <random>
 #include <string>
 #include <utility>
 
+#include "domus/core/config.hpp"
 #include "domus/core/graph/attributes.hpp"
 #include "domus/core/graph/cycle.hpp"
 #include "domus/core/graph/graph.hpp"
 #include "domus/core/graph/graphs_algorithms.hpp"
-#include "domus/sat/cnf.hpp"
 #include "domus/sat/sat.hpp"
 
 #include "../../core/domus_debug.hpp"
 #include "clauses_functions.hpp"
+#include "cnf_dumper.hpp"
+#include "local_search.hpp"
+#include "shape_session.hpp"
 #include "variables_handler.hpp"
 
 namespace domus::orthogonal::shape {
@@ -27,6 +32,7 @@ using namespace graph;
 Shape result_to_shape(
     const Graph& graph, const std::vector<int>& numbers, VariablesHandler& handler
 ) {
+    handler.reset_variables_values();
     for (const int var : numbers) {
         if (var > 0)
             handler.set_variable_value(static_cast<size_t>(var), true);
@@ -42,55 +48,274 @@ Shape result_to_shape(
     return shape;
 }
 
-size_t find_edge_id_to_split(
-    const std::vector<std::string>& proof_lines,
-    std::mt19937& random_engine,
-    const VariablesHandler& handler,
-    size_t number_of_variables
+graph::Subdivision add_corner_inside_edge(
+    size_t edge_id, Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles
 ) {
-    std::vector<int> unit_clauses;
-    for (size_t i = proof_lines.size(); i > 0; i--) {
-        const std::string& line = proof_lines[i - 1];
-        // split line based on " "
-        std::vector<int> tokens;
-        std::string token;
-        for (char c : line) {
-            if (c == 'd')
-                continue;
-            if (c == ' ') {
-                if (token.empty())
-                    continue;
-                tokens.push_back(std::stoi(token));
-                token = "";
-            } else
-                token += c;
-        }
-        DOMUS_ASSERT(token == "0", "find_edges_to_split: last token should be 0");
-        if (tokens.size() == 1) {
-            int unit_clause = tokens[0];
-            if (static_cast<size_t>(std::abs(unit_clause)) <= number_of_variables)
-                unit_clauses.push_back(unit_clause);
+    graph::Subdivision subdivision = graph.subdivide_edge(edge_id);
+    attributes.set_node_color(subdivision.in_between_id, Color::RED);
+    for (Cycle& cycle : cycles)
+        if (cycle.has_edge_id(edge_id)) {
+            graph.add_subdivision_to_cycle(subdivision, cycle);
+            DOMUS_ASSERT(
+                is_cycle_in_graph(graph, cycle),
+                "add_corner_inside_edge: after subdividing cycle is not valid"
+            );
         }
+    return subdivision;
+}
+
+// the session must forget every constraint that depends on the subdivided edge
+void add_corner_inside_edge(
+    size_t edge_id,
+    Graph& graph,
+    Attributes& attributes,
+    std::vector<Cycle>& cycles,
+    ShapeSession& session
+) {
+    const auto [from_id, to_id] = graph.get_edge(edge_id);
+    session.retire_edge(edge_id);
+    session.retire_node(from_id);
+    session.retire_node(to_id);
+    for (size_t i = 0; i < cycles.size(); ++i)
+        if (cycles[i].has_edge_id(edge_id))
+            session.retire_cycle(i);
+    const graph::Subdivision subdivision =
+        add_corner_inside_edge(edge_id, graph, attributes, cycles);
+    session.split_phase(edge_id, subdivision);
+}
+
+std::expected<BudgetPolicy, std::string> string_to_budget_policy(const std::string& policy) {
+    if (policy == "fail")
+        return BudgetPolicy::FAIL;
+    if (policy == "solve_without_budget")
+        return BudgetPolicy::SOLVE_WITHOUT_BUDGET;
+    if (policy == "add_corner")
+        return BudgetPolicy::ADD_CORNER;
+    return std::unexpected("Invalid sat_budget_policy value: " + policy);
+}
+
+std::string cycle_basis_to_string(CycleBasis basis) {
+    switch (basis) {
+    case CycleBasis::SPANNING_TREE:
+        return "spanning_tree";
+    case CycleBasis::BREADTH_FIRST_TREE:
+        return "breadth_first_tree";
+    case CycleBasis::SHORT_CYCLES:
+        return "short_cycles";
+    default:
+        DOMUS_ASSERT(false, "cycle_basis_to_string: invalid basis");
+        return "Invalid basis";
     }
-    DOMUS_ASSERT(
-        !unit_clauses.empty(),
-        "find_edges_to_split: no unit clauses found"
-    ); // Could not find the edge to remove
-    // pick one of the first two unit clauses
-    size_t random_index = random_engine() % std::min(unit_clauses.size(), static_cast<size_t>(2));
-    size_t variable = static_cast<size_t>(std::abs(unit_clauses[random_index]));
-    return handler.get_edge_id_of_variable(variable);
 }
 
-std::optional<Shape> build_shape_or_add_corner(
-    Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles, std::mt19937& random_engine
-);
+std::expected<CycleBasis, std::string> string_to_cycle_basis(const std::string& basis) {
+    if (basis == "spanning_tree")
+        return CycleBasis::SPANNING_TREE;
+    if (basis == "breadth_first_tree")
+        return CycleBasis::BREADTH_FIRST_TREE;
+    if (basis == "short_cycles")
+        return CycleBasis::SHORT_CYCLES;
+    return std::unexpected("Invalid cycle_basis value: " + basis);
+}
+
+// the shape formulas have clauses with more than 2 literals
+std::expected<void, std::string> check_shape_backend_type(const SatBackendType type) {
+    if (type == SatBackendType::TWO_SAT)
+        return std::unexpected(std::string(
+            "SAT backend 2-sat cannot solve shape formulas, they have clauses with more than 2 "
+            "literals"
+        ));
+    return {};
+}
+
+std::expected<ShapeBuilderOptions, std::string> get_shape_builder_options(const Config& config) {
+    ShapeBuilderOptions options;
+    const std::string symmetry_breaking = config.get_or("symmetry_breaking", "false");
+    if (symmetry_breaking != "true" && symmetry_breaking != "false")
+        return std::unexpected("Invalid symmetry_breaking value: " + symmetry_breaking);
+    options.break_symmetries = symmetry_breaking == "true";
+    auto sat_threads = config.get_number<uint64_t>("sat_threads");
+    if (!sat_threads)
+        return std::unexpected(sat_threads.error());
+    options.sat_threads = static_cast<size_t>(sat_threads->value_or(0));
+    auto conflict_limit = config.get_number<uint64_t>("sat_conflict_limit");
+    if (!conflict_limit)
+        return std::unexpected(conflict_limit.error());
+    options.conflict_limit = *conflict_limit;
+    auto propagation_limit = config.get_number<uint64_t>("sat_propagation_limit");
+    if (!propagation_limit)
+        return std::unexpected(propagation_limit.error());
+    options.propagation_limit = *propagation_limit;
+    auto time_limit = config.get_number<uint64_t>("sat_time_limit_ms");
+    if (!time_limit)
+        return std::unexpected(time_limit.error());
+    if (time_limit->has_value())
+        options.time_limit =
+            std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(**time_limit));
+    auto policy = string_to_budget_policy(config.get_or("sat_budget_policy", "fail"));
+    if (!policy)
+        return std::unexpected(policy.error());
+    options.budget_policy = *policy;
+    auto split_batch_size = config.get_number<uint64_t>("split_batch_size");
+    if (!split_batch_size)
+        return std::unexpected(split_batch_size.error());
+    if (split_batch_size->value_or(1) == 0)
+        return std::unexpected(std::string("Invalid split_batch_size value: 0"));
+    options.split_batch_size = static_cast<size_t>(split_batch_size->value_or(1));
+    auto local_search_flips = config.get_number<uint64_t>("local_search_flips");
+    if (!local_search_flips)
+        return std::unexpected(local_search_flips.error());
+    options.local_search_flips = static_cast<size_t>(local_search_flips->value_or(0));
+    const std::string lazy_cycles = config.get_or("lazy_cycles", "false");
+    if (lazy_cycles != "true" && lazy_cycles != "false")
+        return std::unexpected("Invalid lazy_cycles value: " + lazy_cycles);
+    options.lazy_cycles = lazy_cycles == "true";
+    auto cycle_basis = string_to_cycle_basis(config.get_or("cycle_basis", "spanning_tree"));
+    if (!cycle_basis)
+        return std::unexpected(cycle_basis.error());
+    options.cycle_basis = *cycle_basis;
+    if (const std::optional<std::string> directory = config.get("cnf_dump_dir"))
+        options.cnf_dump_directory = *directory;
+    if (const std::optional<std::string> path = config.get("sat_rules")) {
+        auto rules = Config::create(*path).and_then([](const std::unique_ptr<Config>& file) {
+            return SolverRules::create(*file);
+        });
+        if (!rules)
+            return std::unexpected(rules.error());
+        for (const SolverRule& rule : rules->get_rules())
+            if (auto checked = check_shape_backend_type(rule.configuration.backend_type);
+                !checked)
+                return std::unexpected(checked.error());
+        options.solver_rules = std::move(*rules);
+    }
+    auto backend_options = get_sat_backend_options(config);
+    if (!backend_options)
+        return std::unexpected(backend_options.error());
+    options.backend_options = std::move(*backend_options);
+    auto backend_type = get_sat_backend_type(config);
+    if (!backend_type)
+        return std::unexpected(backend_type.error());
+    if (auto checked = check_shape_backend_type(*backend_type); !checked)
+        return std::unexpected(checked.error());
+    options.backend_type = *backend_type;
+    return options;
+}
+
+ShapeBuilder::ShapeBuilder(const ShapeBuilderOptions& options)
+    : m_random_engine(options.randomize ? std::random_device{}() : 42), m_options(options) {
+    m_budget.conflicts = options.conflict_limit;
+    m_budget.propagations = options.propagation_limit;
+    if (options.time_limit.has_value())
+        m_budget.deadline = std::chrono::steady_clock::now() + *options.time_limit;
+}
+
+ShapeBuilder::~ShapeBuilder() = default;
+
+ShapeBuilder::ShapeBuilder(ShapeBuilder&&) noexcept = default;
+
+ShapeBuilder& ShapeBuilder::operator=(ShapeBuilder&&) noexcept = default;
+
+size_t pick_random_edge(const Graph& graph, std::mt19937& random_engine) {
+    std::vector<size_t> edge_ids;
+    graph.for_each_node([&](size_t node_id) {
+        graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t) {
+            edge_ids.push_back(edge_id);
+        });
+    });
+    DOMUS_ASSERT(!edge_ids.empty(), "pick_random_edge: graph has no edges");
+    return edge_ids[random_engine() % edge_ids.size()];
+}
+
+SolverConfiguration ShapeBuilder::select_configuration(
+    const Graph& graph, const Attributes& attributes, const std::vector<Cycle>& cycles
+) const {
+    const SolverConfiguration fallback{m_options.backend_type, m_options.backend_options};
+    if (!m_options.solver_rules.has_value())
+        return fallback;
+    const ShapeFormulaFeatures features =
+        compute_shape_formula_features(graph, attributes, cycles);
+    return m_options.solver_rules->select(features).value_or(fallback);
+}
+
+// the clauses learned by the previous session are lost, its shape is still the warm start
+std::expected<void, std::string>
+ShapeBuilder::create_session(const Graph& graph, const SolverConfiguration& configuration) {
+    auto created = SatBackend::create(
+        configuration.backend_type, m_options.sat_threads, configuration.backend_options
+    );
+    if (!created)
+        return std::unexpected(created.error());
+    std::unique_ptr<SatBackend> backend = std::move(*created);
+    if (m_options.cnf_dump_directory.has_value()) {
+        auto recorder = std::make_unique<RecordingBackend>(std::move(backend));
+        m_recorder = recorder.get();
+        backend = std::move(recorder);
+        if (!m_cnf_dumper)
+            m_cnf_dumper = std::make_unique<CnfDumper>(*m_options.cnf_dump_directory);
+    }
+    // only cube-and-conquer splits the search into cubes
+    const size_t number_of_cube_edges =
+        configuration.backend_type == SatBackendType::CUBE_AND_CONQUER
+            ? get_number_of_cube_edges(m_options.sat_threads)
+            : 0;
+    auto session = std::make_unique<ShapeSession>(
+        graph, std::move(backend), m_options.break_symmetries, number_of_cube_edges
+    );
+    if (m_session)
+        session->set_phases(m_session->get_phases());
+    m_session = std::move(session);
+    m_configuration = configuration;
+    return {};
+}
+
+std::string SplitStats::to_string() const {
+    return std::format("rounds: {}, split edges: {}", number_of_rounds, number_of_split_edges);
+}
 
-Shape build_shape(
-    Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles, const bool randomize
+// adds to edges_to_split the edges of the core, in order, that share no constraint of the
+// core and no node with the edges already there, until there are batch_size edges
+void add_independent_edges(
+    const Graph& graph,
+    const std::vector<size_t>& core_edges,
+    const std::vector<std::vector<size_t>>& constraints_edges,
+    size_t batch_size,
+    std::vector<size_t>& edges_to_split
 ) {
-    const size_t seed = randomize ? std::random_device{}() : 42;
-    std::mt19937 random_engine(seed);
+    std::vector<size_t> used_nodes;
+    std::vector<bool> is_constraint_used(constraints_edges.size(), false);
+    auto use = [&](size_t edge_id) {
+        const auto [from_id, to_id] = graph.get_edge(edge_id);
+        used_nodes.push_back(from_id);
+        used_nodes.push_back(to_id);
+        for (size_t i = 0; i < constraints_edges.size(); ++i)
+            if (std::ranges::find(constraints_edges[i], edge_id) != constraints_edges[i].end())
+                is_constraint_used[i] = true;
+    };
+    auto is_independent = [&](size_t edge_id) {
+        const auto [from_id, to_id] = graph.get_edge(edge_id);
+        if (std::ranges::find(used_nodes, from_id) != used_nodes.end() ||
+            std::ranges::find(used_nodes, to_id) != used_nodes.end())
+            return false;
+        for (size_t i = 0; i < constraints_edges.size(); ++i)
+            if (is_constraint_used[i] &&
+                std::ranges::find(constraints_edges[i], edge_id) != constraints_edges[i].end())
+                return false;
+        return true;
+    };
+    for (size_t edge_id : edges_to_split)
+        use(edge_id);
+    for (size_t edge_id : core_edges) {
+        if (edges_to_split.size() >= batch_size)
+            return;
+        if (!is_independent(edge_id))
+            continue;
+        edges_to_split.push_back(edge_id);
+        use(edge_id);
+    }
+}
+
+std::expected<Shape, std::string>
+ShapeBuilder::build_shape(Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles) {
     DOMUS_ASSERT(
         [&]() {
             for (const Cycle& cycle : cycles)
@@ -98,55 +323,97 @@ Shape build_shape(
                     return false;
             return true;
         }(),
-        "build_shape: a cycle is not valid"
+        "ShapeBuilder::build_shape: a cycle is not valid"
     );
-    std::optional<Shape> shape =
-        build_shape_or_add_corner(graph, attributes, cycles, random_engine);
-    while (!shape.has_value())
-        shape = build_shape_or_add_corner(graph, attributes, cycles, random_engine);
-    return std::move(shape.value());
-}
-
-void add_corner_inside_edge(
-    size_t edge_id, Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles
-) {
-    graph::Subdivision subdivision = graph.subdivide_edge(edge_id);
-    attributes.set_node_color(subdivision.in_between_id, Color::RED);
-    for (Cycle& cycle : cycles)
-        if (cycle.has_edge_id(edge_id)) {
-            graph.add_subdivision_to_cycle(subdivision, cycle);
+    const SolverConfiguration configuration = select_configuration(graph, attributes, cycles);
+    // ShapeBuilderOptions can also be filled in without get_shape_builder_options
+    if (auto checked = check_shape_backend_type(configuration.backend_type); !checked)
+        return std::unexpected(checked.error());
+    if (!m_session || configuration != m_configuration)
+        if (auto created = create_session(graph, configuration); !created)
+            return std::unexpected(created.error());
+    const size_t iteration = m_number_of_calls++;
+    // the formulas of the later calls are usually satisfiable by a few changes of the
+    // previous shape, the solver is only needed if the local search fails
+    if (m_options.local_search_flips > 0)
+        if (std::optional<Shape> shape = find_shape_with_local_search(
+                graph,
+                cycles,
+                m_session->get_phases(),
+                m_options.local_search_flips,
+                m_random_engine
+            )) {
             DOMUS_ASSERT(
-                is_cycle_in_graph(graph, cycle),
-                "add_corner_inside_edge: after subdividing cycle is not valid"
+                is_shape_valid(graph, *shape), "ShapeBuilder::build_shape: shape is not valid"
             );
+            m_session->set_phases(*shape);
+            return std::move(*shape);
         }
-}
-
-std::optional<Shape> build_shape_or_add_corner(
-    Graph& graph, Attributes& attributes, std::vector<Cycle>& cycles, std::mt19937& random_engine
-) {
-    VariablesHandler handler(graph);
-    cnf::Cnf cnf{};
-    // cnf.add_comment("constraints one direction per edge");
-    add_constraints_one_direction_per_edge(graph, cnf, handler);
-    // cnf.add_comment("constraints nodes");
-    add_nodes_constraints(graph, cnf, handler);
-    // cnf.add_comment("constraints cycles");
-    add_cycles_constraints(graph, cnf, cycles, handler);
-    const auto [result, numbers, proof_lines] = launch_glucose(cnf);
-    if (result == SatSolverResultType::UNSAT) {
-        const size_t edge_id = find_edge_id_to_split(
-            proof_lines,
-            random_engine,
-            handler,
-            cnf.get_number_of_variables()
-        );
-        add_corner_inside_edge(edge_id, graph, attributes, cycles);
-        return std::nullopt;
+    SatSolverBudget budget = m_budget;
+    while (true) {
+        m_session->sync(graph, cycles);
+        const SatSolverResult result = m_session->solve(budget);
+        m_sat_stats += result.stats;
+        if (m_cnf_dumper) {
+            auto dumped = m_cnf_dumper->dump(
+                m_recorder->get_formula(),
+                m_recorder->get_last_assumptions(),
+                graph,
+                cycles.size(),
+                iteration,
+                result.result
+            );
+            if (!dumped)
+                return std::unexpected(dumped.error());
+        }
+        if (result.result == SatSolverResultType::UNKNOWN) {
+            switch (m_options.budget_policy) {
+            case BudgetPolicy::SOLVE_WITHOUT_BUDGET:
+                budget = {};
+                continue;
+            case BudgetPolicy::ADD_CORNER:
+                // without a core any edge can be split, every bend makes the formula easier
+                if (!budget.is_expired()) {
+                    const size_t edge_id = pick_random_edge(graph, m_random_engine);
+                    add_corner_inside_edge(edge_id, graph, attributes, cycles, *m_session);
+                    continue;
+                }
+                break;
+            default:
+                break;
+            }
+            return std::unexpected("ShapeBuilder::build_shape: SAT solver out of budget");
+        }
+        if (result.result == SatSolverResultType::SAT) {
+            Shape shape = result_to_shape(graph, result.numbers, m_session->get_handler());
+            DOMUS_ASSERT(
+                is_shape_valid(graph, shape),
+                "ShapeBuilder::build_shape: shape is not valid"
+            );
+            // the next call differs by a cycle or a bend, the shape is almost a solution
+            m_session->set_phases(shape);
+            return shape;
+        }
+        const std::vector<size_t> edges =
+            m_session->get_edges_in_core(graph, cycles, result.failed_assumptions);
+        // pick one of the first two edges of the core
+        std::vector<size_t> edges_to_split = {
+            edges[m_random_engine() % std::min(edges.size(), size_t{2})]
+        };
+        if (m_options.split_batch_size > 1)
+            add_independent_edges(
+                graph,
+                edges,
+                m_session->get_constraints_edges_in_core(graph, cycles, result.failed_assumptions),
+                m_options.split_batch_size,
+                edges_to_split
+            );
+        // the other edges keep their ids when an edge is subdivided
+        for (size_t edge_id : edges_to_split)
+            add_corner_inside_edge(edge_id, graph, attributes, cycles, *m_session);
+        m_split_stats.number_of_rounds++;
+        m_split_stats.number_of_split_edges += edges_to_split.size();
     }
-    Shape shape = result_to_shape(graph, numbers, handler);
-    DOMUS_ASSERT(is_shape_valid(graph, shape), "build_shape_or_add_corner: shape is not valid");
-    return shape;
 }
 
 } // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,333 @@
+#include "shape_session.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+#include "domus/sat/clause_sink.hpp"
+
+#include "../../core/domus_debug.hpp"
+#include "clauses_functions.hpp"
+
+namespace domus::orthogonal::shape {
+using namespace graph;
+using namespace sat;
+
+ShapeSession::ShapeSession(
+    const Graph& graph,
+    std::unique_ptr<SatBackend> solver,
+    const bool break_symmetries,
+    const size_t number_of_cube_edges
+)
+    : m_handler(graph), m_solver(std::move(solver)), m_break_symmetries(break_symmetries),
+      m_number_of_cube_edges(number_of_cube_edges) {}
+
+size_t ShapeSession::add_guard(GuardType type, size_t id) {
+    const size_t activation = m_handler.add_auxiliary_variable();
+    if (m_activation_to_guard.size() <= activation)
+        m_activation_to_guard.resize(activation + 1);
+    m_activation_to_guard[activation] = Guard{type, id};
+    return activation;
+}
+
+void ShapeSession::retire(std::optional<size_t>& activation) {
+    if (!activation.has_value())
+        return;
+    // the guarded clauses are permanently satisfied, the solver will drop them
+    sat::add_clause(*m_solver, {-static_cast<int>(*activation)});
+    m_activation_to_guard[*activation] = std::nullopt;
+    activation = std::nullopt;
+}
+
+void ShapeSession::retire_edge(size_t edge_id) {
+    if (edge_id >= m_is_edge_encoded.size() || !m_is_edge_encoded[edge_id])
+        return;
+    m_is_edge_encoded[edge_id] = false;
+    if (m_symmetry_activation.has_value() &&
+        (m_symmetry_edges.first == edge_id || m_symmetry_edges.second == edge_id))
+        retire(m_symmetry_activation);
+    // the edge id can be reused by the graph, so it gets fresh variables
+    m_handler.add_edge_variables(edge_id);
+}
+
+void ShapeSession::retire_node(size_t node_id) {
+    if (node_id < m_node_activation.size())
+        retire(m_node_activation[node_id]);
+}
+
+void ShapeSession::retire_cycle(size_t cycle_index) {
+    if (cycle_index < m_cycle_activation.size())
+        retire(m_cycle_activation[cycle_index]);
+}
+
+void ShapeSession::encode_edge(size_t edge_id) {
+    if (m_is_edge_encoded.size() <= edge_id)
+        m_is_edge_encoded.resize(edge_id + 1);
+    add_constraints_one_direction_per_edge(*m_solver, m_handler, edge_id);
+    m_is_edge_encoded[edge_id] = true;
+}
+
+void ShapeSession::encode_node(const Graph& graph, size_t node_id) {
+    if (m_node_activation.size() <= node_id)
+        m_node_activation.resize(node_id + 1);
+    const size_t activation = add_guard(GuardType::NODE, node_id);
+    sat::GuardedSink<sat::SatBackend> sink(*m_solver, static_cast<int>(activation));
+    add_node_constraints(graph, sink, m_handler, node_id);
+    m_node_activation[node_id] = activation;
+}
+
+void ShapeSession::encode_cycle(const Graph& graph, const Cycle& cycle, size_t cycle_index) {
+    if (m_cycle_activation.size() <= cycle_index)
+        m_cycle_activation.resize(cycle_index + 1);
+    const size_t activation = add_guard(GuardType::CYCLE, cycle_index);
+    sat::GuardedSink<sat::SatBackend> sink(*m_solver, static_cast<int>(activation));
+    add_cycle_constraints(graph, sink, cycle, m_handler);
+    m_cycle_activation[cycle_index] = activation;
+}
+
+void ShapeSession::encode_symmetry_breaking(const Graph& graph) {
+    const auto edges = find_symmetry_breaking_edges(graph);
+    if (!edges.has_value())
+        return;
+    const size_t activation = add_guard(GuardType::SYMMETRY, 0);
+    sat::GuardedSink<sat::SatBackend> sink(*m_solver, static_cast<int>(activation));
+    add_symmetry_breaking_clauses(sink, m_handler, edges->first, edges->second);
+    m_symmetry_activation = activation;
+    m_symmetry_edges = *edges;
+}
+
+void ShapeSession::sync(const Graph& graph, const std::vector<Cycle>& cycles) {
+    // edges first, nodes and cycles clauses need the variables of their edges
+    graph.for_each_node([&](size_t node_id) {
+        graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t) {
+            if (edge_id < m_is_edge_encoded.size() && m_is_edge_encoded[edge_id])
+                return;
+            if (!m_handler.has_edge_variables(edge_id))
+                m_handler.add_edge_variables(edge_id);
+            encode_edge(edge_id);
+        });
+    });
+    m_solver->reserve_variables(m_handler.get_number_of_variables());
+    if (m_break_symmetries && !m_symmetry_activation.has_value())
+        encode_symmetry_breaking(graph);
+    graph.for_each_node([&](size_t node_id) {
+        if (node_id >= m_node_activation.size() || !m_node_activation[node_id].has_value())
+            encode_node(graph, node_id);
+    });
+    for (size_t i = 0; i < cycles.size(); ++i)
+        if (i >= m_cycle_activation.size() || !m_cycle_activation[i].has_value())
+            encode_cycle(graph, cycles[i], i);
+    if (m_number_of_cube_edges > 0)
+        set_cubes(graph, cycles);
+}
+
+// the cube edges get all the combinations of directions, 4^MAX_CUBE_EDGES cubes at most
+constexpr size_t MAX_CUBE_EDGES = 4;
+
+// more cubes than threads, so that a thread stuck on a hard cube does not idle the others
+constexpr size_t CUBES_PER_THREAD = 4;
+
+size_t get_number_of_cube_edges(size_t number_of_threads) {
+    if (number_of_threads == 0)
+        number_of_threads =
+            std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+    size_t number_of_cube_edges = 1;
+    while (number_of_cube_edges < MAX_CUBE_EDGES &&
+           (size_t{1} << (2 * number_of_cube_edges)) < CUBES_PER_THREAD * number_of_threads)
+        ++number_of_cube_edges;
+    return number_of_cube_edges;
+}
+
+// lookahead on the structure of the graph: the edges between high degree nodes, then the
+// ones on long cycles, constrain the most variables once their direction is fixed;
+// two cube edges never share a node, so that few cubes are trivially inconsistent
+std::vector<size_t> find_cube_edges(
+    const Graph& graph,
+    const std::vector<Cycle>& cycles,
+    size_t number_of_cube_edges,
+    const std::optional<std::pair<size_t, size_t>>& excluded_edges
+) {
+    struct Candidate {
+        size_t edge_id;
+        size_t node_id;
+        size_t neighbor_id;
+        size_t degrees;
+        size_t cycles_length;
+    };
+    std::vector<Candidate> candidates;
+    graph.for_each_node([&](size_t node_id) {
+        graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t neighbor_id) {
+            if (excluded_edges.has_value() &&
+                (edge_id == excluded_edges->first || edge_id == excluded_edges->second))
+                return;
+            size_t cycles_length = 0;
+            for (const Cycle& cycle : cycles)
+                if (cycle.has_edge_id(edge_id))
+                    cycles_length += cycle.size();
+            const size_t degrees =
+                graph.get_degree_of_node(node_id) + graph.get_degree_of_node(neighbor_id);
+            candidates.push_back({edge_id, node_id, neighbor_id, degrees, cycles_length});
+        });
+    });
+    std::ranges::stable_sort(candidates, [](const Candidate& a, const Candidate& b) {
+        return std::tie(a.degrees, a.cycles_length) > std::tie(b.degrees, b.cycles_length);
+    });
+    std::vector<size_t> cube_edges;
+    std::vector<size_t> used_nodes;
+    for (const Candidate& candidate : candidates) {
+        if (cube_edges.size() == number_of_cube_edges)
+            break;
+        if (std::ranges::find(used_nodes, candidate.node_id) != used_nodes.end() ||
+            std::ranges::find(used_nodes, candidate.neighbor_id) != used_nodes.end())
+            continue;
+        cube_edges.push_back(candidate.edge_id);
+        used_nodes.push_back(candidate.node_id);
+        used_nodes.push_back(candidate.neighbor_id);
+    }
+    return cube_edges;
+}
+
+// one cube for each combination of directions of the cube edges, the edge clauses give
+// every edge a direction so the cubes cover every assignment
+std::vector<std::vector<int>>
+make_cubes(const VariablesHandler& handler, const std::vector<size_t>& cube_edges) {
+    std::vector<std::vector<int>> cubes{{}};
+    for (size_t edge_id : cube_edges) {
+        std::vector<std::vector<int>> extended_cubes;
+        for (const std::vector<int>& cube : cubes)
+            for (Direction direction : get_all_directions()) {
+                std::vector<int>& extended = extended_cubes.emplace_back(cube);
+                for (int literal : handler.get_direction_literals(edge_id, direction))
+                    extended.push_back(literal);
+            }
+        cubes = std::move(extended_cubes);
+    }
+    return cubes;
+}
+
+// the edges of the symmetry breaking clauses are left out, most of their cubes would be
+// refuted by those clauses alone
+void ShapeSession::set_cubes(const Graph& graph, const std::vector<Cycle>& cycles) {
+    std::optional<std::pair<size_t, size_t>> excluded_edges;
+    if (m_symmetry_activation.has_value())
+        excluded_edges = m_symmetry_edges;
+    const std::vector<size_t> cube_edges =
+        find_cube_edges(graph, cycles, m_number_of_cube_edges, excluded_edges);
+    m_solver->set_cubes(make_cubes(m_handler, cube_edges));
+}
+
+void ShapeSession::set_phases(const Shape& shape) { m_phases = shape; }
+
+const Shape& ShapeSession::get_phases() const { return m_phases; }
+
+void ShapeSession::split_phase(size_t edge_id, const Subdivision& subdivision) {
+    if (!m_phases.contains(edge_id))
+        return;
+    // the edge id can be reused by one of the halves
+    const Direction direction = m_phases.get_direction(edge_id);
+    m_phases.remove_direction(edge_id);
+    m_phases.set_direction(subdivision.edge_from_between_id, direction);
+    m_phases.set_direction(subdivision.edge_between_to_id, direction);
+}
+
+// with one variable per direction the other directions are false,
+// with the compact encoding the literals of the direction already fix both variables
+void ShapeSession::add_phase_literals(size_t edge_id, Direction direction) {
+    for (const Direction other : get_all_directions()) {
+        const DirectionLiterals literals = m_handler.get_direction_literals(edge_id, other);
+        if (other == direction)
+            m_phase_literals.insert(m_phase_literals.end(), literals.begin(), literals.end());
+        else if (LITERALS_PER_DIRECTION == 1)
+            m_phase_literals.push_back(-literals[0]);
+    }
+}
+
+SatSolverResult ShapeSession::solve(const SatSolverBudget& budget) {
+    m_assumptions.clear();
+    auto assume_active = [this](const std::vector<std::optional<size_t>>& activations) {
+        for (const std::optional<size_t>& activation : activations)
+            if (activation.has_value())
+                m_assumptions.push_back(static_cast<int>(*activation));
+    };
+    assume_active(m_node_activation);
+    assume_active(m_cycle_activation);
+    if (m_symmetry_activation.has_value())
+        m_assumptions.push_back(static_cast<int>(*m_symmetry_activation));
+    m_phase_literals.clear();
+    for (size_t edge_id = 0; edge_id < m_is_edge_encoded.size(); ++edge_id)
+        if (m_is_edge_encoded[edge_id] && m_phases.contains(edge_id))
+            add_phase_literals(edge_id, m_phases.get_direction(edge_id));
+    if (!m_phase_literals.empty())
+        m_solver->set_phases(m_phase_literals);
+    m_solver->set_budget(budget);
+    return m_solver->solve(m_assumptions);
+}
+
+std::vector<std::vector<size_t>> ShapeSession::get_constraints_edges_in_core(
+    const Graph& graph,
+    const std::vector<Cycle>& cycles,
+    const std::vector<int>& failed_assumptions
+) const {
+    std::vector<std::vector<size_t>> constraints_edges;
+    for (int literal : failed_assumptions) {
+        const size_t activation = static_cast<size_t>(std::abs(literal));
+        if (activation >= m_activation_to_guard.size() ||
+            !m_activation_to_guard[activation].has_value())
+            continue;
+        const auto [type, id] = *m_activation_to_guard[activation];
+        std::vector<size_t> edges;
+        switch (type) {
+        case GuardType::NODE:
+            graph.for_each_edge(id, [&](size_t edge_id, size_t) { edges.push_back(edge_id); });
+            break;
+        case GuardType::CYCLE:
+            for (size_t i = 0; i < cycles[id].size(); ++i)
+                edges.push_back(cycles[id].edge_id_at(i));
+            break;
+        case GuardType::SYMMETRY:
+            // the symmetry breaking clauses alone never cause a refutation
+            continue;
+        }
+        constraints_edges.push_back(std::move(edges));
+    }
+    return constraints_edges;
+}
+
+// the edges in order of first appearance, then the ones shared by most constraints first
+std::vector<size_t> sort_by_occurrences(const std::vector<std::vector<size_t>>& constraints_edges) {
+    std::vector<size_t> edges;
+    std::vector<size_t> occurrences;
+    for (const std::vector<size_t>& constraint_edges : constraints_edges)
+        for (size_t edge_id : constraint_edges) {
+            if (occurrences.size() <= edge_id)
+                occurrences.resize(edge_id + 1, 0);
+            if (occurrences[edge_id]++ == 0)
+                edges.push_back(edge_id);
+        }
+    std::ranges::stable_sort(edges, std::greater{}, [&](size_t edge_id) {
+        return occurrences[edge_id];
+    });
+    return edges;
+}
+
+std::vector<size_t> ShapeSession::get_edges_in_core(
+    const Graph& graph,
+    const std::vector<Cycle>& cycles,
+    const std::vector<int>& failed_assumptions
+) const {
+    std::vector<size_t> edges =
+        sort_by_occurrences(get_constraints_edges_in_core(graph, cycles, failed_assumptions));
+    DOMUS_ASSERT(!edges.empty(), "ShapeSession::get_edges_in_core: empty core");
+    return edges;
+}
+
+VariablesHandler& ShapeSession::get_handler() { return m_handler; }
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "domus/orthogonal/shape/shape.hpp"
+#include "domus/sat/sat.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+#include "variables_handler.hpp"
+
+namespace domus::graph {
+class Cycle;
+class Graph;
+struct Subdivision;
+} // namespace domus::graph
+
+namespace domus::orthogonal::shape {
+
+// keeps the shape formula of a graph inside a single incremental solver,
+// the clauses of each node and cycle are guarded by an activation literal
+// so that they can be retired when the graph changes, learned clauses are kept
+// (edge clauses are never retired: a subdivided edge gets fresh variables instead);
+// the symmetry breaking clauses are guarded too and move to new edges when theirs are retired;
+// with cube edges every sync gives the backend one cube for each combination of their
+// directions
+class ShapeSession {
+    enum class GuardType { NODE, CYCLE, SYMMETRY };
+    struct Guard {
+        GuardType type;
+        size_t id;
+    };
+    VariablesHandler m_handler;
+    std::unique_ptr<sat::SatBackend> m_solver;
+    std::vector<bool> m_is_edge_encoded;
+    std::vector<std::optional<size_t>> m_node_activation;
+    std::vector<std::optional<size_t>> m_cycle_activation;
+    bool m_break_symmetries;
+    std::optional<size_t> m_symmetry_activation;
+    std::pair<size_t, size_t> m_symmetry_edges;
+    std::vector<std::optional<Guard>> m_activation_to_guard;
+    std::vector<int> m_assumptions;
+    Shape m_phases;
+    std::vector<int> m_phase_literals;
+    size_t m_number_of_cube_edges;
+    size_t add_guard(GuardType type, size_t id);
+    void retire(std::optional<size_t>& activation);
+    void encode_edge(size_t edge_id);
+    void encode_node(const graph::Graph& graph, size_t node_id);
+    void encode_cycle(const graph::Graph& graph, const graph::Cycle& cycle, size_t cycle_index);
+    void encode_symmetry_breaking(const graph::Graph& graph);
+    void add_phase_literals(size_t edge_id, Direction direction);
+    void set_cubes(const graph::Graph& graph, const std::vector<graph::Cycle>& cycles);
+
+  public:
+    ShapeSession(
+        const graph::Graph& graph,
+        std::unique_ptr<sat::SatBackend> solver,
+        bool break_symmetries = false,
+        size_t number_of_cube_edges = 0
+    );
+    void retire_edge(size_t edge_id);
+    void retire_node(size_t node_id);
+    void retire_cycle(size_t cycle_index);
+    // adds the clauses of all edges, nodes and cycles that are not currently encoded
+    void sync(const graph::Graph& graph, const std::vector<graph::Cycle>& cycles);
+    // the directions of the shape are tried first by the next solves (warm start)
+    void set_phases(const Shape& shape);
+    // the shape of the last set_phases, with the subdivided edges split
+    const Shape& get_phases() const;
+    // both halves of a subdivided edge keep the direction of the edge as phase
+    void split_phase(size_t edge_id, const graph::Subdivision& subdivision);
+    sat::SatSolverResult solve(const sat::SatSolverBudget& budget = {});
+    // edges of the constraints used in the last refutation, the ones shared by most
+    // constraints first
+    std::vector<size_t> get_edges_in_core(
+        const graph::Graph& graph,
+        const std::vector<graph::Cycle>& cycles,
+        const std::vector<int>& failed_assumptions
+    ) const;
+    // the edges of each node and cycle constraint used in the last refutation
+    std::vector<std::vector<size_t>> get_constraints_edges_in_core(
+        const graph::Graph& graph,
+        const std::vector<graph::Cycle>& cycles,
+        const std::vector<int>& failed_assumptions
+    ) const;
+    VariablesHandler& get_handler();
+};
+
+// enough cube edges for a few cubes per thread, one thread per hardware thread if
+// number_of_threads is 0
+size_t get_number_of_cube_edges(size_t number_of_threads);
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "domus/orthogonal/shape/solver_selection.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <format>
+#include <span>
+#include <sstream>
+
+#include "domus/core/config.hpp"
+#include "domus/core/graph/attributes.hpp"
+#include "domus/core/graph/cycle.hpp"
+#include "domus/core/graph/graph.hpp"
+
+#include "clauses_functions.hpp"
+#include "variables_handler.hpp"
+
+namespace domus::orthogonal::shape {
+using namespace sat;
+using namespace graph;
+
+std::optional<double> ShapeFormulaFeatures::get(std::string_view name) const {
+    if (name == "variables")
+        return static_cast<double>(number_of_variables);
+    if (name == "clauses")
+        return static_cast<double>(number_of_clauses);
+    if (name == "unit_clauses")
+        return static_cast<double>(clause_length_histogram[0]);
+    if (name == "binary_clauses")
+        return static_cast<double>(clause_length_histogram[1]);
+    if (name == "ternary_clauses")
+        return static_cast<double>(clause_length_histogram[2]);
+    if (name == "long_clauses")
+        return static_cast<double>(clause_length_histogram[3]);
+    if (name == "cycles")
+        return static_cast<double>(number_of_cycles);
+    if (name == "max_degree")
+        return static_cast<double>(max_degree);
+    if (name == "subdivision_fraction")
+        return subdivision_fraction;
+    return std::nullopt;
+}
+
+std::string ShapeFormulaFeatures::to_string() const {
+    return std::format(
+        "variables={} clauses={} (1: {}, 2: {}, 3: {}, 4+: {}) cycles={} max_degree={} "
+        "subdivision_fraction={:.3f}",
+        number_of_variables,
+        number_of_clauses,
+        clause_length_histogram[0],
+        clause_length_histogram[1],
+        clause_length_histogram[2],
+        clause_length_histogram[3],
+        number_of_cycles,
+        max_degree,
+        subdivision_fraction
+    );
+}
+
+// keeps the number of clauses of each length
+struct ClauseLengthSink {
+    ShapeFormulaFeatures& features;
+
+    void add_clause(std::span<const int> clause) {
+        for (int lit : clause)
+            reserve_variables(static_cast<size_t>(std::abs(lit)));
+        features.number_of_clauses++;
+        features.clause_length_histogram[std::clamp(clause.size(), size_t{1}, size_t{4}) - 1]++;
+    }
+
+    void reserve_variables(size_t variables) {
+        features.number_of_variables = std::max(features.number_of_variables, variables);
+    }
+};
+
+ShapeFormulaFeatures compute_shape_formula_features(
+    const Graph& graph, const Attributes& attributes, const std::vector<Cycle>& cycles
+) {
+    ShapeFormulaFeatures features;
+    ClauseLengthSink sink{features};
+    VariablesHandler handler(graph);
+    add_constraints_one_direction_per_edge(graph, sink, handler);
+    add_nodes_constraints(graph, sink, handler);
+    add_cycles_constraints(graph, sink, cycles, handler);
+    features.number_of_cycles = cycles.size();
+    size_t number_of_subdivisions = 0;
+    graph.for_each_node([&](size_t node_id) {
+        features.max_degree = std::max(features.max_degree, graph.get_degree_of_node(node_id));
+        if (attributes.get_node_color(node_id) == Color::RED)
+            number_of_subdivisions++;
+    });
+    if (graph.get_number_of_nodes() > 0)
+        features.subdivision_fraction = static_cast<double>(number_of_subdivisions) /
+                                        static_cast<double>(graph.get_number_of_nodes());
+    return features;
+}
+
+std::string SolverConfiguration::to_string() const {
+    const std::string options = backend_options.to_string();
+    return sat_backend_type_to_string(backend_type) + (options.empty() ? "" : " " + options);
+}
+
+bool FeatureCondition::holds(const ShapeFormulaFeatures& features) const {
+    // the feature was checked when the rules were loaded
+    const double feature_value = features.get(feature).value_or(0.0);
+    if (comparison == "<")
+        return feature_value < value;
+    if (comparison == "<=")
+        return feature_value <= value;
+    if (comparison == ">")
+        return feature_value > value;
+    if (comparison == ">=")
+        return feature_value >= value;
+    return feature_value == value;
+}
+
+std::string FeatureCondition::to_string() const {
+    return std::format("{}{}{}", feature, comparison, value);
+}
+
+std::expected<FeatureCondition, std::string> parse_condition(const std::string& text) {
+    const size_t position = text.find_first_of("<>=");
+    if (position == std::string::npos || position == 0)
+        return std::unexpected("Invalid rule condition: " + text);
+    FeatureCondition condition;
+    condition.feature = text.substr(0, position);
+    if (!ShapeFormulaFeatures{}.get(condition.feature).has_value())
+        return std::unexpected("Unknown feature in rule condition: " + text);
+    const size_t value_position =
+        position + 1 < text.size() && text[position + 1] == '=' ? position + 2 : position + 1;
+    condition.comparison = text.substr(position, value_position - position);
+    if (condition.comparison == "=")
+        return std::unexpected("Invalid comparison in rule condition: " + text);
+    const char* end = text.data() + text.size();
+    const auto [ptr, error] = std::from_chars(text.data() + value_position, end, condition.value);
+    if (error != std::errc{} || ptr != end)
+        return std::unexpected("Invalid value in rule condition: " + text);
+    return condition;
+}
+
+std::expected<std::vector<FeatureCondition>, std::string>
+parse_conditions(const std::string& text) {
+    std::vector<FeatureCondition> conditions;
+    std::istringstream stream(text);
+    std::string word;
+    while (stream >> word) {
+        auto condition = parse_condition(word);
+        if (!condition)
+            return std::unexpected(condition.error());
+        conditions.push_back(std::move(*condition));
+    }
+    return conditions;
+}
+
+std::expected<SolverRules, std::string> SolverRules::create(const Config& config) {
+    const std::string number_of_rules = config.get_or("rules", "0");
+    size_t size = 0;
+    const char* end = number_of_rules.data() + number_of_rules.size();
+    const auto [ptr, error] = std::from_chars(number_of_rules.data(), end, size);
+    if (error != std::errc{} || ptr != end)
+        return std::unexpected("Invalid rules value: " + number_of_rules);
+    std::vector<SolverRule> rules;
+    for (size_t i = 0; i < size; ++i) {
+        const std::string prefix = std::format("rule_{}_", i);
+        auto conditions = parse_conditions(config.get_or(prefix + "when", ""));
+        if (!conditions)
+            return std::unexpected(conditions.error());
+        auto backend_type = get_sat_backend_type(config, prefix);
+        if (!backend_type)
+            return std::unexpected(backend_type.error());
+        auto backend_options = get_sat_backend_options(config, prefix);
+        if (!backend_options)
+            return std::unexpected(backend_options.error());
+        rules.push_back({std::move(*conditions), {*backend_type, std::move(*backend_options)}});
+    }
+    return SolverRules(std::move(rules));
+}
+
+std::optional<SolverConfiguration>
+SolverRules::select(const ShapeFormulaFeatures& features) const {
+    for (const auto& [conditions, configuration] : m_rules)
+        if (std::ranges::all_of(conditions, [&](const FeatureCondition& condition) {
+                return condition.holds(features);
+            }))
+            return configuration;
+    return std::nullopt;
+}
+
+std::string SolverRules::to_config() const {
+    std::string config = std::format("rules={}\n", m_rules.size());
+    for (size_t i = 0; i < m_rules.size(); ++i) {
+        const auto& [conditions, configuration] = m_rules[i];
+        const std::string prefix = std::format("rule_{}_", i);
+        std::string when;
+        for (const FeatureCondition& condition : conditions)
+            when += (when.empty() ? "" : " ") + condition.to_string();
+        config += std::format("{}when={}\n", prefix, when);
+        config += std::format(
+            "{}sat_backend={}\n", prefix, sat_backend_type_to_string(configuration.backend_type)
+        );
+        config += sat_backend_options_to_config(configuration.backend_options, prefix);
+    }
+    return config;
+}
+
+} // namespace domus::orthogonal::shape
\ No newline at end of file
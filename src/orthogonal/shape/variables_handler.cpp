@@ -1,5 +1,7 @@
 #include "variables_handler.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <format>
 #include <print>
 
@@ -9,45 +11,52 @@
 
 namespace domus::orthogonal::shape {
 
-void VariablesHandler::add_variable(size_t edge_id, const Direction direction) {
+size_t VariablesHandler::add_variable(size_t edge_id, const Direction direction) {
     m_variable_to_edge_id.push_back(edge_id);
     m_variable_to_direction.push_back(direction);
     m_variable_to_value.push_back(-1);
-    switch (direction) {
-    case Direction::UP:
-        m_edge_up_variable[edge_id] = m_next_var;
-        break;
-    case Direction::DOWN:
-        m_edge_down_variable[edge_id] = m_next_var;
-        break;
-    case Direction::LEFT:
-        m_edge_left_variable[edge_id] = m_next_var;
-        break;
-    case Direction::RIGHT:
-        m_edge_right_variable[edge_id] = m_next_var;
-        break;
-    case Direction::INVALID:
-        DOMUS_ASSERT(false, "VariablesHandler::add_variable: invalid direction");
-        break;
-    }
-    m_next_var++;
+    return m_next_var++;
 }
 
 void VariablesHandler::add_edge_variables(size_t edge_id) {
-    add_variable(edge_id, Direction::UP);
-    add_variable(edge_id, Direction::DOWN);
-    add_variable(edge_id, Direction::LEFT);
-    add_variable(edge_id, Direction::RIGHT);
+    if (m_edge_variables.size() <= edge_id)
+        m_edge_variables.resize(edge_id + 1);
+#ifdef DOMUS_COMPACT_DIRECTIONS
+    // the variables are named after the direction in which both are true
+    const size_t horizontal = add_variable(edge_id, Direction::RIGHT);
+    const size_t positive = add_variable(edge_id, Direction::RIGHT);
+    m_edge_variables[edge_id] = {horizontal, positive};
+#else
+    const size_t up = add_variable(edge_id, Direction::UP);
+    const size_t down = add_variable(edge_id, Direction::DOWN);
+    const size_t left = add_variable(edge_id, Direction::LEFT);
+    const size_t right = add_variable(edge_id, Direction::RIGHT);
+    m_edge_variables[edge_id] = {up, down, left, right};
+#endif
 }
 
+bool VariablesHandler::has_edge_variables(size_t edge_id) const {
+    return edge_id < m_edge_variables.size() && m_edge_variables[edge_id].has_value();
+}
+
+size_t VariablesHandler::add_auxiliary_variable() {
+    m_variable_to_edge_id.push_back(m_variable_to_edge_id.front());
+    m_variable_to_direction.push_back(Direction::INVALID);
+    m_variable_to_value.push_back(-1);
+    return m_next_var++;
+}
+
+size_t VariablesHandler::add_edge_auxiliary_variable(size_t edge_id) {
+    return add_variable(edge_id, Direction::INVALID);
+}
+
+size_t VariablesHandler::get_number_of_variables() const { return m_next_var - 1; }
+
 VariablesHandler::VariablesHandler(const graph::Graph& graph) {
     m_variable_to_edge_id.push_back(graph.get_number_of_edges());
     m_variable_to_direction.push_back(Direction::INVALID);
     m_variable_to_value.push_back(-1);
-    m_edge_up_variable.resize(graph.get_number_of_edges());
-    m_edge_down_variable.resize(graph.get_number_of_edges());
-    m_edge_left_variable.resize(graph.get_number_of_edges());
-    m_edge_right_variable.resize(graph.get_number_of_edges());
+    m_edge_variables.resize(graph.get_number_of_edges());
     graph.for_each_node([&](size_t node_id) {
         graph.for_each_out_edge(node_id, [&](size_t edge_id, size_t) {
             add_edge_variables(edge_id);
@@ -55,33 +64,40 @@ VariablesHandler::VariablesHandler(const graph::Graph& graph) {
     });
 }
 
-size_t VariablesHandler::get_up_variable(size_t edge_id) const {
-    return m_edge_up_variable.at(edge_id).value();
-}
-
-size_t VariablesHandler::get_down_variable(size_t edge_id) const {
-    return m_edge_down_variable.at(edge_id).value();
-}
-
-size_t VariablesHandler::get_left_variable(size_t edge_id) const {
-    return m_edge_left_variable.at(edge_id).value();
-}
-
-size_t VariablesHandler::get_right_variable(size_t edge_id) const {
-    return m_edge_right_variable.at(edge_id).value();
-}
-
-size_t VariablesHandler::get_variable(size_t edge_id, Direction direction) const {
-    if (direction == Direction::UP)
-        return get_up_variable(edge_id);
-    if (direction == Direction::DOWN)
-        return get_down_variable(edge_id);
-    if (direction == Direction::LEFT)
-        return get_left_variable(edge_id);
-    if (direction == Direction::RIGHT)
-        return get_right_variable(edge_id);
-    DOMUS_ASSERT(false, "VariablesHandler::get_variable: invalid direction");
-    return 0;
+DirectionLiterals
+VariablesHandler::get_direction_literals(size_t edge_id, Direction direction) const {
+    const auto& variables = m_edge_variables.at(edge_id).value();
+#ifdef DOMUS_COMPACT_DIRECTIONS
+    const int horizontal = static_cast<int>(variables[0]);
+    const int positive = static_cast<int>(variables[1]);
+    switch (direction) {
+    case Direction::UP:
+        return {-horizontal, positive};
+    case Direction::DOWN:
+        return {-horizontal, -positive};
+    case Direction::LEFT:
+        return {horizontal, -positive};
+    case Direction::RIGHT:
+        return {horizontal, positive};
+    case Direction::INVALID:
+        break;
+    }
+#else
+    switch (direction) {
+    case Direction::UP:
+        return {static_cast<int>(variables[0])};
+    case Direction::DOWN:
+        return {static_cast<int>(variables[1])};
+    case Direction::LEFT:
+        return {static_cast<int>(variables[2])};
+    case Direction::RIGHT:
+        return {static_cast<int>(variables[3])};
+    case Direction::INVALID:
+        break;
+    }
+#endif
+    DOMUS_ASSERT(false, "VariablesHandler::get_direction_literals: invalid direction");
+    return {};
 }
 
 size_t VariablesHandler::get_edge_id_of_variable(size_t variable) const {
@@ -89,14 +105,16 @@ size_t VariablesHandler::get_edge_id_of_variable(size_t variable) const {
 }
 
 Direction VariablesHandler::get_direction_of_edge(size_t edge_id) const {
-    if (get_variable_value(get_up_variable(edge_id)))
-        return Direction::UP;
-    if (get_variable_value(get_down_variable(edge_id)))
-        return Direction::DOWN;
-    if (get_variable_value(get_left_variable(edge_id)))
-        return Direction::LEFT;
-    if (get_variable_value(get_right_variable(edge_id)))
-        return Direction::RIGHT;
+    auto has_direction = [&](Direction direction) {
+        for (int literal : get_direction_literals(edge_id, direction))
+            if (get_variable_value(static_cast<size_t>(std::abs(literal))) != (literal > 0))
+                return false;
+        return true;
+    };
+    for (const Direction direction :
+         {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT})
+        if (has_direction(direction))
+            return direction;
     DOMUS_ASSERT(
         false,
         "VariablesHandler::get_direction_of_edge: no direction found for standard edge"
@@ -112,6 +130,10 @@ void VariablesHandler::set_variable_value(size_t variable, bool value) {
     m_variable_to_value[variable] = value;
 }
 
+void VariablesHandler::reset_variables_values() {
+    std::ranges::fill(m_variable_to_value, -1);
+}
+
 bool VariablesHandler::get_variable_value(size_t variable) const {
     DOMUS_ASSERT(
         m_variable_to_value.at(variable) != -1,
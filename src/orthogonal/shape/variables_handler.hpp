@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "domus/core/graph/graph_utilities.hpp"
 #include "domus/orthogonal/shape/direction.hpp"
@@ -10,28 +13,44 @@ class Graph;
 }
 
 namespace domus::orthogonal::shape {
+
+// with DOMUS_COMPACT_DIRECTIONS an edge has two variables, horizontal (LEFT or RIGHT) and
+// positive (UP or RIGHT), and a direction is the conjunction of two literals; otherwise an
+// edge has one variable per direction and the clauses must force exactly one of them
+#ifdef DOMUS_COMPACT_DIRECTIONS
+inline constexpr size_t VARIABLES_PER_EDGE = 2;
+inline constexpr size_t LITERALS_PER_DIRECTION = 2;
+#else
+inline constexpr size_t VARIABLES_PER_EDGE = 4;
+inline constexpr size_t LITERALS_PER_DIRECTION = 1;
+#endif
+
+// the edge has the direction iff all the literals are true
+using DirectionLiterals = std::array<int, LITERALS_PER_DIRECTION>;
+
 class VariablesHandler {
     size_t m_next_var = 1; // 0 is reserved for the empty clause
     std::vector<size_t> m_variable_to_edge_id;
     std::vector<Direction> m_variable_to_direction;
     std::vector<int> m_variable_to_value;
-    std::vector<std::optional<size_t>> m_edge_up_variable;
-    std::vector<std::optional<size_t>> m_edge_down_variable;
-    std::vector<std::optional<size_t>> m_edge_right_variable;
-    std::vector<std::optional<size_t>> m_edge_left_variable;
-    void add_variable(size_t edge_id, Direction direction);
-    void add_edge_variables(size_t edge_id);
+    std::vector<std::optional<std::array<size_t, VARIABLES_PER_EDGE>>> m_edge_variables;
+    size_t add_variable(size_t edge_id, Direction direction);
 
   public:
     VariablesHandler(const graph::Graph& graph);
-    size_t get_up_variable(size_t edge_id) const;
-    size_t get_down_variable(size_t edge_id) const;
-    size_t get_left_variable(size_t edge_id) const;
-    size_t get_right_variable(size_t edge_id) const;
-    size_t get_variable(size_t edge_id, Direction direction) const;
+    // (re)assigns fresh variables to the edge, previous variables of the edge are left unused
+    void add_edge_variables(size_t edge_id);
+    bool has_edge_variables(size_t edge_id) const;
+    // variable not associated with any edge
+    size_t add_auxiliary_variable();
+    // variable that is not a direction of the edge, but is reported as a variable of the edge
+    size_t add_edge_auxiliary_variable(size_t edge_id);
+    size_t get_number_of_variables() const;
+    DirectionLiterals get_direction_literals(size_t edge_id, Direction direction) const;
     size_t get_edge_id_of_variable(size_t variable) const;
     void set_variable_value(size_t variable, bool value);
     bool get_variable_value(size_t variable) const;
+    void reset_variables_values();
     Direction get_direction_of_edge(size_t edge_id) const;
     std::string to_string() const;
     void print() const;
@@ -142,8 +142,9 @@ Cycle make_cycle_good(const Graph& graph, const Cycle& cycle, const Segment& seg
             continue;
         attachments_to_use.push_back(i);
     }
-    const Path path =
-        compute_path_between_attachments(segment, attachments_to_use[0], attachments_to_use[1]);
+    const Path path = compute_path_between_attachments(
+        segment, attachments_to_use[0], attachments_to_use[1], cycle.size()
+    );
     auto& nodes_labels = segment.get_new_id_to_old_id();
     auto& edge_labels = segment.get_edge_labels();
     Path old_path;
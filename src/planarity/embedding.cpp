@@ -101,6 +101,39 @@ size_t compute_number_of_faces_in_embedding(const Embedding& embedding) {
     return number_of_faces;
 }
 
+size_t find_edge_id(const Graph& graph, size_t node_id, size_t neighbor_id) {
+    for (auto [edge_id, other_id] : graph.get_edges(node_id))
+        if (other_id == neighbor_id)
+            return edge_id;
+    DOMUS_ASSERT(false, "find_edge_id: nodes are not neighbors");
+    return 0;
+}
+
+std::vector<graph::Path> compute_faces_in_embedding(const Embedding& embedding) {
+    const Graph& graph = embedding.get_graph();
+    std::vector<graph::Path> faces;
+    std::unordered_set<graph::Edge, edge_hash> visited_edges; // visited oriented edges
+    embedding.for_each_node([&](size_t node_id) {
+        embedding.for_each_neighbor(node_id, [&](size_t neighbor_id) {
+            if (visited_edges.contains({node_id, neighbor_id}))
+                return;
+            graph::Path face;
+            size_t current_node = node_id;
+            size_t next_node = neighbor_id;
+            while (!visited_edges.contains({current_node, next_node})) {
+                visited_edges.insert({current_node, next_node});
+                face.push_back(graph, current_node, find_edge_id(graph, current_node, next_node));
+                size_t successor =
+                    embedding.next_element_in_adjacency_list(next_node, current_node);
+                current_node = next_node;
+                next_node = successor;
+            }
+            faces.push_back(std::move(face));
+        });
+    });
+    return faces;
+}
+
 bool is_embedding_planar(const Embedding& embedding) {
     return compute_embedding_genus(embedding) == 0;
 }
@@ -60,7 +60,10 @@ bool is_segment_a_path(const Segment& segment) {
 }
 
 Path compute_path_between_attachments(
-    const Segment& segment, const size_t attachment_1, const size_t attachment_2
+    const Segment& segment,
+    const size_t attachment_1,
+    const size_t attachment_2,
+    const size_t cycle_size
 ) {
     NodesLabels edge_id_to_prev(segment.get_segment());
     std::deque<size_t> queue;
@@ -69,9 +72,10 @@ Path compute_path_between_attachments(
         const size_t node_id = queue.front();
         queue.pop_front();
         for (const auto [edge_id, neighbor_id] : segment.get_segment().get_edges(node_id)) {
+            // the path goes inside the segment, not along the cycle
+            if (node_id == attachment_1 && neighbor_id < cycle_size)
+                continue;
             if (neighbor_id == attachment_2) {
-                if (node_id == attachment_1)
-                    continue;
                 edge_id_to_prev.add_label(neighbor_id, edge_id);
                 break;
             }
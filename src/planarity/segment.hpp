@@ -67,8 +67,9 @@ class Segment {
 
 bool is_segment_a_path(const Segment& segment);
 
+// the nodes of the cycle are the first cycle_size nodes of the segment
 Path compute_path_between_attachments(
-    const Segment& segment, size_t attachment_1, size_t attachment_2
+    const Segment& segment, size_t attachment_1, size_t attachment_2, size_t cycle_size
 );
 
 } // namespace domus::planarity
\ No newline at end of file
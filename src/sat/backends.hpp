@@ -0,0 +1,36 @@
+#pragma once
+
+#include <expected>
+#include <memory>
+#include <string>
+
+#include "domus/sat/sat_backend.hpp"
+
+namespace domus::sat {
+
+std::unique_ptr<SatBackend> create_glucose_backend(const SatBackendOptions& options);
+
+std::unique_ptr<SatBackend>
+create_glucose_parallel_backend(size_t number_of_threads, const SatBackendOptions& options);
+
+// an error if options.kissat_configuration is unknown
+std::expected<std::unique_ptr<SatBackend>, std::string>
+create_kissat_backend(const SatBackendOptions& options);
+
+// one glucose worker per thread, one per hardware thread if number_of_threads is 0
+std::unique_ptr<SatBackend>
+create_cube_and_conquer_backend(size_t number_of_threads, const SatBackendOptions& options);
+
+// glucose and kissat on the same formula, an error if options.kissat_configuration is unknown
+std::expected<std::unique_ptr<SatBackend>, std::string>
+create_portfolio_backend(const SatBackendOptions& options);
+
+// false if kissat has no configuration with this name
+bool is_kissat_configuration(const std::string& name);
+
+std::unique_ptr<SatBackend> create_two_sat_backend();
+
+// only available if built with DOMUS_WITH_IPASIR
+std::unique_ptr<SatBackend> create_ipasir_backend();
+
+} // namespace domus::sat
\ No newline at end of file
@@ -1,34 +1,46 @@
 #include "domus/sat/cnf.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cstdlib>
-#include <filesystem>
 #include <format>
 #include <fstream>
-#include <mutex>
 #include <print>
+#include <span>
 #include <utility>
 
 namespace domus::sat::cnf {
 
-const std::string project_path = std::filesystem::current_path().string() + "/";
-const std::string cnf_logs_file = "cnf_logs.txt";
-std::mutex cnf_logs_mutex;
-
-void Cnf::add_clause(std::vector<int> clause) {
+void Cnf::add_clause(std::span<const int> clause) {
     for (int lit : clause)
         m_num_vars = static_cast<size_t>(std::max(static_cast<int>(m_num_vars), abs(lit)));
-    m_rows.push_back({CnfRowType::CLAUSE, std::move(clause), ""});
-    m_num_clauses++;
+    m_literals.insert(m_literals.end(), clause.begin(), clause.end());
+    m_clause_offsets.push_back(m_literals.size());
+}
+
+void Cnf::add_clause(std::initializer_list<int> clause) {
+    add_clause(std::span<const int>(clause.begin(), clause.size()));
 }
 
 void Cnf::add_comment(const std::string& comment) {
-    m_rows.push_back({CnfRowType::COMMENT, {}, comment});
+    m_comments.emplace_back(get_number_of_clauses(), comment);
+}
+
+void Cnf::reserve_variables(size_t number_of_variables) {
+    m_num_vars = std::max(m_num_vars, number_of_variables);
 }
 
 size_t Cnf::get_number_of_variables() const { return m_num_vars; }
 
-size_t Cnf::get_number_of_clauses() const { return m_num_clauses; }
+size_t Cnf::get_number_of_clauses() const { return m_clause_offsets.size() - 1; }
+
+size_t Cnf::get_number_of_literals() const { return m_literals.size(); }
+
+std::span<const int> Cnf::get_clause(size_t clause_index) const {
+    const size_t begin = m_clause_offsets[clause_index];
+    return {m_literals.data() + begin, m_clause_offsets[clause_index + 1] - begin};
+}
 
 std::expected<void, std::string> Cnf::save_to_file(const std::string& file_path) const {
     std::ofstream file(file_path);
@@ -36,40 +48,93 @@ std::expected<void, std::string> Cnf::save_to_file(const std::string& file_path)
         return std::unexpected(std::format("Cnf::save_to_file: could not open file {}", file_path));
     }
     file << to_string();
-    std::lock_guard lock(cnf_logs_mutex);
-    std::ofstream log_file(cnf_logs_file, std::ios_base::app);
-    if (!log_file) {
+    if (!file)
         return std::unexpected(
-            std::format("Cnf::save_to_file: could not open file {}", cnf_logs_file)
+            std::format("Cnf::save_to_file: could not write file {}", file_path)
         );
-    }
-    log_file << "v " << get_number_of_variables();
-    log_file << " c " << get_number_of_clauses() << "\n";
-    log_file.close();
     return {};
 }
 
+const std::vector<std::pair<size_t, std::string>>& Cnf::get_comments() const {
+    return m_comments;
+}
+
+// a single pass over the text, numbers are read in place with from_chars
+std::expected<Cnf, std::string> Cnf::parse_dimacs(std::string_view text) {
+    Cnf cnf;
+    std::vector<int> clause;
+    const char* position = text.data();
+    const char* const end = text.data() + text.size();
+    auto line_end = [&]() { return std::find(position, end, '\n'); };
+    auto is_space = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+    while (true) {
+        while (position != end && is_space(*position))
+            ++position;
+        if (position == end)
+            break;
+        if (*position == 'c') {
+            const char* const comment_end = line_end();
+            const char* comment_begin = position + 1;
+            if (comment_begin != comment_end && *comment_begin == ' ')
+                ++comment_begin;
+            cnf.add_comment(std::string(comment_begin, comment_end));
+            position = comment_end;
+            continue;
+        }
+        if (*position == 'p') {
+            const char* const header_end = line_end();
+            const std::string_view header(position, header_end);
+            position = header_end;
+            // p cnf <variables> <clauses>
+            const size_t format_end = header.find("cnf");
+            if (format_end == std::string_view::npos)
+                return std::unexpected(std::format("Cnf::parse_dimacs: invalid header {}", header));
+            const char* number = header.data() + format_end + 3;
+            while (number != header_end && is_space(*number))
+                ++number;
+            size_t number_of_variables = 0;
+            if (std::from_chars(number, header_end, number_of_variables).ec != std::errc{})
+                return std::unexpected(std::format("Cnf::parse_dimacs: invalid header {}", header));
+            cnf.reserve_variables(number_of_variables);
+            continue;
+        }
+        int lit = 0;
+        const auto [next, error] = std::from_chars(position, end, lit);
+        if (error != std::errc{})
+            return std::unexpected(std::format(
+                "Cnf::parse_dimacs: invalid literal at offset {}",
+                static_cast<size_t>(position - text.data())
+            ));
+        position = next;
+        if (lit != 0) {
+            clause.push_back(lit);
+            continue;
+        }
+        cnf.add_clause(clause);
+        clause.clear();
+    }
+    if (!clause.empty())
+        return std::unexpected("Cnf::parse_dimacs: the last clause is not terminated by 0");
+    return cnf;
+}
+
 std::string Cnf::to_string() const {
     std::string result;
     auto out = std::back_inserter(result);
-    std::format_to(out, " p cnf {} {}\n", get_number_of_variables(), get_number_of_clauses());
-    for (const auto& row : m_rows) {
-        switch (row.type) {
-        case CnfRowType::COMMENT:
-            std::format_to(out, "c {}\n", row.comment);
-            break;
-        case CnfRowType::CLAUSE:
-            for (int lit : row.clause)
-                std::format_to(out, "{} ", lit);
-            std::format_to(out, "0\n");
+    std::format_to(out, "p cnf {} {}\n", get_number_of_variables(), get_number_of_clauses());
+    size_t next_comment = 0;
+    for (size_t i = 0; i <= get_number_of_clauses(); ++i) {
+        while (next_comment < m_comments.size() && m_comments[next_comment].first == i)
+            std::format_to(out, "c {}\n", m_comments[next_comment++].second);
+        if (i == get_number_of_clauses())
             break;
-        }
+        for (int lit : get_clause(i))
+            std::format_to(out, "{} ", lit);
+        std::format_to(out, "0\n");
     }
     return result;
 }
 
 void Cnf::print() const { println("{}", to_string()); }
 
-const std::vector<CnfRow>& Cnf::get_rows() const { return m_rows; }
-
 } // namespace domus::sat::cnf
\ No newline at end of file
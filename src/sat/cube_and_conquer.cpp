@@ -0,0 +1,261 @@
+#include "domus/sat/sat_backend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "backends.hpp"
+#include "glucose_solver.hpp"
+#include "solver_interrupter.hpp"
+#include "solver_timer.hpp"
+
+namespace domus::sat {
+
+using namespace Glucose;
+
+// a worker keeps its solver (and its learned clauses) from one cube to the next,
+// and from one solve to the next
+class CubeWorker {
+    TunedSolver m_solver;
+    vec<Lit> m_lits;
+    SatSolverStats m_before;
+
+  public:
+    explicit CubeWorker(const SatBackendOptions& options) : m_solver(options) {}
+
+    void add_clause(std::span<const int> clause) {
+        m_lits.clear();
+        for (int lit : clause)
+            add_literal(m_solver, m_lits, lit);
+        m_solver.addClause_(m_lits);
+    }
+
+    void reserve_variables(size_t number_of_variables) {
+        while (static_cast<size_t>(m_solver.nVars()) < number_of_variables)
+            m_solver.newVar();
+    }
+
+    void set_phases(std::span<const int> literals) {
+        for (int lit : literals) {
+            const int var = abs(lit) - 1;
+            if (var < m_solver.nVars())
+                m_solver.setPolarity(var, lit < 0);
+        }
+    }
+
+    // called before each search, the interruption of the previous one must not stop it
+    void start() {
+        m_solver.clearInterrupt();
+        m_before = get_solver_stats(m_solver);
+    }
+
+    lbool solve(
+        const std::vector<int>& assumptions,
+        std::span<const int> cube,
+        const SatSolverBudget& budget
+    ) {
+        m_lits.clear();
+        for (int lit : assumptions)
+            add_literal(m_solver, m_lits, lit);
+        for (int lit : cube)
+            add_literal(m_solver, m_lits, lit);
+        return solve_within_budget(m_solver, m_lits, budget);
+    }
+
+    void interrupt() { m_solver.interrupt(); }
+
+    // the failed assumptions of the last UNSAT solve
+    std::vector<int> get_failed_assumptions() const {
+        std::vector<int> failed;
+        for (int i = 0; i < m_solver.conflict.size(); i++) {
+            const Lit lit = ~m_solver.conflict[i];
+            failed.push_back(sign(lit) ? -(var(lit) + 1) : var(lit) + 1);
+        }
+        return failed;
+    }
+
+    std::vector<int> get_model() const {
+        std::vector<int> numbers;
+        for (int i = 0; i < m_solver.nVars(); i++)
+            if (m_solver.model[i] != l_Undef)
+                numbers.push_back((m_solver.model[i] == l_True) ? i + 1 : -(i + 1));
+        return numbers;
+    }
+
+    // the counters since the last start
+    SatSolverStats get_stats(const SolverTimer& timer) const {
+        return get_solve_stats(m_solver, m_before, timer);
+    }
+
+    size_t get_number_of_variables() const { return static_cast<size_t>(m_solver.nVars()); }
+};
+
+// the workers pull the cubes in order, the first SAT cube (or a core that does not depend
+// on the cube, which refutes all of them) stops the search
+struct CubeSearch {
+    std::atomic<size_t> next_cube = 0;
+    std::atomic<size_t> number_of_solved_cubes = 0;
+    std::atomic<bool> is_stopped = false;
+    std::atomic<bool> is_budget_exhausted = false;
+    std::mutex mutex;
+    std::optional<SatSolverResult> winner;
+    std::vector<std::vector<int>> cores;
+};
+
+// the core of a cube without its literals
+std::vector<int> remove_cube_literals(std::vector<int> core, std::span<const int> cube) {
+    std::erase_if(core, [&](int lit) { return std::ranges::find(cube, lit) != cube.end(); });
+    return core;
+}
+
+// the failed assumptions of every cube, the most frequent first (ties by first appearance)
+std::vector<int> combine_cores(const std::vector<std::vector<int>>& cores) {
+    std::vector<int> combined;
+    std::unordered_map<int, size_t> frequency;
+    for (const std::vector<int>& core : cores)
+        for (int lit : core)
+            if (frequency[lit]++ == 0)
+                combined.push_back(lit);
+    std::ranges::stable_sort(combined, [&](int a, int b) { return frequency[a] > frequency[b]; });
+    return combined;
+}
+
+// the formula is solved under the assumptions plus each cube of the last set_cubes (one
+// glucose worker per thread, taking the cubes in order) and the first SAT cube stops the
+// search; if every cube is UNSAT, the core is the failed assumptions (not the cube literals)
+// of all the cubes, the most frequent first, which is a core if the cubes cover every
+// assignment; without cubes a single worker solves the formula
+class CubeAndConquerBackend final : public SatBackend {
+    std::vector<std::unique_ptr<CubeWorker>> m_workers;
+    std::vector<std::vector<int>> m_cubes;
+    SatBackendStats m_stats;
+
+  public:
+    CubeAndConquerBackend(size_t number_of_threads, const SatBackendOptions& options) {
+        for (size_t i = 0; i < get_number_of_workers(number_of_threads); ++i)
+            m_workers.push_back(std::make_unique<CubeWorker>(options));
+    }
+
+    void add_clause(std::span<const int> clause) override {
+        for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+            worker->add_clause(clause);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+            worker->reserve_variables(number_of_variables);
+    }
+
+    void set_cubes(const std::vector<std::vector<int>>& cubes) override { m_cubes = cubes; }
+
+    // the deadline is shared by all the cubes, the other limits hold for each cube
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        const SolverTimer timer;
+        m_stats.number_of_solves++;
+        const std::vector<std::vector<int>> no_cubes{{}};
+        const std::vector<std::vector<int>>& cubes = m_cubes.empty() ? no_cubes : m_cubes;
+        const size_t number_of_workers = std::min(m_workers.size(), cubes.size());
+        for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+            worker->start();
+        CubeSearch search;
+        search.cores.resize(cubes.size());
+        auto stop_all = [&]() {
+            search.is_stopped = true;
+            for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+                worker->interrupt();
+        };
+        auto finish = [&](SatSolverResult result) {
+            {
+                std::lock_guard lock(search.mutex);
+                if (search.winner.has_value())
+                    return;
+                search.winner = std::move(result);
+            }
+            stop_all();
+        };
+        SatSolverBudget cube_budget = get_budget();
+        cube_budget.deadline.reset();
+        {
+            const DeadlineWatchdog watchdog(get_budget(), stop_all);
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < number_of_workers; ++i)
+                threads.emplace_back([&, i]() {
+                    CubeWorker& worker = *m_workers[i];
+                    while (!search.is_stopped) {
+                        const size_t cube_index = search.next_cube++;
+                        if (cube_index >= cubes.size())
+                            return;
+                        const std::vector<int>& cube = cubes[cube_index];
+                        const lbool ret = worker.solve(assumptions, cube, cube_budget);
+                        if (ret == l_Undef) {
+                            // either stopped by another worker or out of budget
+                            if (!search.is_stopped)
+                                search.is_budget_exhausted = true;
+                            continue;
+                        }
+                        search.number_of_solved_cubes++;
+                        if (ret == l_True) {
+                            SatSolverResult result;
+                            result.result = SatSolverResultType::SAT;
+                            result.numbers = worker.get_model();
+                            finish(std::move(result));
+                            return;
+                        }
+                        std::vector<int> core = worker.get_failed_assumptions();
+                        const size_t core_size = core.size();
+                        core = remove_cube_literals(std::move(core), cube);
+                        if (core.size() == core_size) {
+                            SatSolverResult result;
+                            result.result = SatSolverResultType::UNSAT;
+                            result.failed_assumptions = std::move(core);
+                            finish(std::move(result));
+                            return;
+                        }
+                        search.cores[cube_index] = std::move(core);
+                    }
+                });
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+        SatSolverResult result;
+        if (search.winner.has_value())
+            result = std::move(*search.winner);
+        else if (search.is_stopped || search.is_budget_exhausted)
+            result.result = SatSolverResultType::UNKNOWN;
+        else {
+            result.result = SatSolverResultType::UNSAT;
+            result.failed_assumptions = combine_cores(search.cores);
+        }
+        for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+            result.stats += worker->get_stats(timer);
+        result.stats.number_of_solves = search.number_of_solved_cubes;
+        result.stats.wall_time_ms = timer.get_elapsed_ms();
+        return result;
+    }
+
+    void set_phases(std::span<const int> literals) override {
+        for (const std::unique_ptr<CubeWorker>& worker : m_workers)
+            worker->set_phases(literals);
+    }
+
+    SatBackendStats get_stats() const override {
+        SatBackendStats stats = m_stats;
+        stats.number_of_variables = m_workers.front()->get_number_of_variables();
+        return stats;
+    }
+};
+
+std::unique_ptr<SatBackend>
+create_cube_and_conquer_backend(size_t number_of_threads, const SatBackendOptions& options) {
+    return std::make_unique<CubeAndConquerBackend>(number_of_threads, options);
+}
+
+} // namespace domus::sat
\ No newline at end of file
@@ -1,18 +1,27 @@
 #include "domus/sat/sat.hpp"
 
-#include <sstream>
+#include <memory>
+#include <optional>
+#include <span>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "domus/sat/clause_sink.hpp"
 #include "domus/sat/cnf.hpp"
 
 #include "../core/domus_debug.hpp"
-#include "../core/memory_file.hpp"
+#include "backends.hpp"
+#include "glucose_solver.hpp"
+#include "solver_interrupter.hpp"
+#include "solver_timer.hpp"
+#include "unit_clauses_proof.hpp"
 
 #include "glucose/src/SimpSolver.h"
 #include "glucose/src/SolverTypes.h"
+#include "glucose/src/System.h"
 #include "glucose/src/Vec.h"
 
 namespace domus::sat {
@@ -21,47 +30,124 @@ using namespace Glucose;
 
 using namespace cnf;
 
-void read_clause(const CnfRow& row, SimpSolver& S, vec<Lit>& lits) {
-    int var;
-    lits.clear();
-    for (int lit : row.clause) {
-        DOMUS_ASSERT(lit != 0, "read_clause: internal errors, found a 0 literal in clause");
-        var = abs(lit) - 1;
-        while (var >= S.nVars())
-            S.newVar();
-        lits.push((lit > 0) ? mkLit(var) : ~mkLit(var));
-    }
+void add_literal(Solver& S, vec<Lit>& lits, int lit) {
+    DOMUS_ASSERT(lit != 0, "add_literal: internal errors, found a 0 literal");
+    int var = abs(lit) - 1;
+    while (var >= S.nVars())
+        S.newVar();
+    lits.push((lit > 0) ? mkLit(var) : ~mkLit(var));
 }
 
-void parse_cnf(const Cnf& cnf, SimpSolver& S) {
-    vec<Lit> lits;
-    for (const CnfRow& row : cnf.get_rows()) {
-        read_clause(row, S, lits);
-        S.addClause_(lits);
+// clause sink writing straight into the solver, works for both Solver and SimpSolver
+class GlucoseSink {
+    Solver& m_solver;
+    vec<Lit> m_lits;
+
+  public:
+    explicit GlucoseSink(Solver& solver) : m_solver(solver) {}
+
+    void add_clause(std::span<const int> clause) {
+        m_lits.clear();
+        for (int lit : clause)
+            add_literal(m_solver, m_lits, lit);
+        m_solver.addClause_(m_lits);
     }
-}
 
-void populate_proof_result(const char* buffer, SatSolverResult& result) {
-    std::istringstream proof(buffer);
-    std::string line;
-    while (std::getline(proof, line))
-        result.proof_lines.push_back(line);
-}
+    void reserve_variables(size_t number_of_variables) {
+        while (static_cast<size_t>(m_solver.nVars()) < number_of_variables)
+            m_solver.newVar();
+    }
+};
 
-SatSolverResult launch_glucose(const Cnf& cnf) {
-    SimpSolver S;
+static_assert(ClauseSink<GlucoseSink>);
+
+void parse_cnf(const Cnf& cnf, SimpSolver& S) {
+    GlucoseSink sink(S);
+    sink.reserve_variables(cnf.get_number_of_variables());
+    for (std::span<const int> clause : cnf.get_clauses())
+        sink.add_clause(clause);
+}
 
+void setup_solver(SimpSolver& S) {
     S.parsing = 1;
     S.use_simplification = true;
     S.verbosity = 0;
     S.verbEveryConflicts = 10000;
     S.showModel = false;
+}
 
-    MemoryFile memory_file_proof = MemoryFile::create().value();
+// counters since the creation of the solver, glucose learns a clause at every conflict
+SatSolverStats get_solver_stats(const Solver& S) {
+    SatSolverStats stats;
+    stats.number_of_solves = 1;
+    stats.conflicts = S.conflicts;
+    stats.decisions = S.decisions;
+    stats.propagations = S.propagations;
+    stats.restarts = S.starts;
+    stats.learned_clauses = S.conflicts;
+    stats.peak_memory_mb = memUsedPeak();
+    return stats;
+}
+
+// counters of the solver after a solve minus the ones before it
+SatSolverStats
+get_solve_stats(const Solver& S, const SatSolverStats& before, const SolverTimer& timer) {
+    SatSolverStats stats = get_solver_stats(S);
+    stats.conflicts -= before.conflicts;
+    stats.decisions -= before.decisions;
+    stats.propagations -= before.propagations;
+    stats.restarts -= before.restarts;
+    stats.learned_clauses -= before.learned_clauses;
+    stats.wall_time_ms = timer.get_elapsed_ms();
+    return stats;
+}
+
+// glucose checks the budget (and the interruption of the deadline) at every restart,
+// the limits are counted from the current counters of the solver
+lbool solve_within_budget(Solver& S, const vec<Lit>& assumptions, const SatSolverBudget& budget) {
+    S.budgetOff();
+    if (budget.conflicts.has_value())
+        S.setConfBudget(static_cast<int64_t>(*budget.conflicts));
+    if (budget.propagations.has_value())
+        S.setPropBudget(static_cast<int64_t>(*budget.propagations));
+    const DeadlineWatchdog watchdog(budget, [&S]() { S.interrupt(); });
+    return S.solveLimited(assumptions);
+}
+
+void populate_result(const Solver& S, const lbool ret, SatSolverResult& result) {
+    if (ret == l_True) {
+        result.result = SatSolverResultType::SAT;
+        for (int i = 0; i < S.nVars(); i++)
+            if (S.model[i] != l_Undef)
+                result.numbers.push_back((S.model[i] == l_True) ? i + 1 : -(i + 1));
+        return;
+    }
+    if (ret == l_Undef) {
+        result.result = SatSolverResultType::UNKNOWN;
+        return;
+    }
+    result.result = SatSolverResultType::UNSAT;
+    // the final conflict is expressed with the negation of the failed assumptions
+    for (int i = 0; i < S.conflict.size(); i++) {
+        const Lit lit = ~S.conflict[i];
+        result.failed_assumptions.push_back(sign(lit) ? -(var(lit) + 1) : var(lit) + 1);
+    }
+}
+
+void populate_model_result(const SimpSolver& S, SatSolverResult& result) {
+    result.result = SatSolverResultType::SAT;
+    for (int i = 0; i < S.nVars(); i++)
+        if (S.model[i] != l_Undef)
+            result.numbers.push_back((S.model[i] == l_True) ? i + 1 : -(i + 1));
+}
+
+SatSolverResult solve_with_proof(SimpSolver& S, const Cnf& cnf, const SatSolverBudget& budget) {
+    const SolverTimer timer;
+    UnitClausesProof proof = UnitClausesProof::create(true).value();
 
     S.certifiedUNSAT = true;
-    S.vbyte = false;
-    S.certifiedOutput = memory_file_proof.get_file();
+    S.vbyte = true;
+    S.certifiedOutput = proof.get_file();
     parse_cnf(cnf, S);
 
     S.parsing = 0;
@@ -69,25 +155,146 @@ SatSolverResult launch_glucose(const Cnf& cnf) {
 
     SatSolverResult result;
     if (!S.okay()) { // UNSAT
-        fprintf(S.certifiedOutput, "0\n");
         result.result = SatSolverResultType::UNSAT;
-        populate_proof_result(memory_file_proof.get_buffer(), result);
+        result.proof_unit_clauses = proof.get_unit_clauses();
+        result.stats = get_solve_stats(S, {}, timer);
         return result;
     }
 
     vec<Lit> dummy;
-    lbool ret = S.solveLimited(dummy);
+    lbool ret = solve_within_budget(S, dummy, budget);
+    result.stats = get_solve_stats(S, {}, timer);
 
-    if (ret == l_True) {
-        result.result = SatSolverResultType::SAT;
-        for (int i = 0; i < S.nVars(); i++)
-            if (S.model[i] != l_Undef)
-                result.numbers.push_back((S.model[i] == l_True) ? i + 1 : -(i + 1));
-    } else {
+    if (ret == l_True)
+        populate_model_result(S, result);
+    else if (ret == l_False) {
         result.result = SatSolverResultType::UNSAT;
-        populate_proof_result(memory_file_proof.get_buffer(), result);
+        result.proof_unit_clauses = proof.get_unit_clauses();
+    } else
+        result.result = SatSolverResultType::UNKNOWN;
+    return result;
+}
+
+std::optional<SatSolverResult> launch_glucose(
+    const Cnf& cnf, const SatSolverBudget& budget, SolverInterrupter& interrupter
+) {
+    SimpSolver S;
+    setup_solver(S);
+    interrupter.attach([&S]() { S.interrupt(); });
+    SatSolverResult result = solve_with_proof(S, cnf, budget);
+    interrupter.detach();
+    if (result.result == SatSolverResultType::UNKNOWN)
+        return std::nullopt;
+    return result;
+}
+
+SatSolverResult launch_glucose(const Cnf& cnf, const SatSolverBudget& budget) {
+    SimpSolver S;
+    setup_solver(S);
+    return solve_with_proof(S, cnf, budget);
+}
+
+SatSolverResult launch_glucose(
+    const Cnf& cnf, const std::vector<int>& assumptions, const SatSolverBudget& budget
+) {
+    const SolverTimer timer;
+    SimpSolver S;
+    setup_solver(S);
+    parse_cnf(cnf, S);
+
+    vec<Lit> lits;
+    for (int lit : assumptions) {
+        DOMUS_ASSERT(lit != 0, "launch_glucose: internal errors, found a 0 assumption");
+        const int var = abs(lit) - 1;
+        while (var >= S.nVars())
+            S.newVar();
+        // assumptions must survive variable elimination
+        S.setFrozen(var, true);
+        lits.push((lit > 0) ? mkLit(var) : ~mkLit(var));
+    }
+
+    S.parsing = 0;
+    S.eliminate(true);
+
+    SatSolverResult result;
+    result.result = SatSolverResultType::UNSAT;
+    if (!S.okay()) {
+        result.stats = get_solve_stats(S, {}, timer);
+        return result;
+    }
+
+    const lbool ret = solve_within_budget(S, lits, budget);
+    result.stats = get_solve_stats(S, {}, timer);
+    if (ret == l_True) {
+        populate_model_result(S, result);
+        return result;
+    }
+    if (ret == l_Undef) {
+        result.result = SatSolverResultType::UNKNOWN;
+        return result;
+    }
+    // the final conflict is expressed with the negation of the failed assumptions
+    for (int i = 0; i < S.conflict.size(); i++) {
+        const Lit lit = ~S.conflict[i];
+        result.failed_assumptions.push_back(sign(lit) ? -(var(lit) + 1) : var(lit) + 1);
     }
     return result;
 }
 
+// plain Solver instead of SimpSolver: eliminated variables could not be reused by later clauses
+class GlucoseBackend final : public SatBackend {
+    TunedSolver m_solver;
+    GlucoseSink m_sink{m_solver};
+    vec<Lit> m_lits;
+    SatBackendStats m_stats;
+
+  public:
+    explicit GlucoseBackend(const SatBackendOptions& options) : m_solver(options) {}
+
+    void add_clause(std::span<const int> clause) override {
+        m_sink.add_clause(clause);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        m_sink.reserve_variables(number_of_variables);
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        const SolverTimer timer;
+        const SatSolverStats before = get_solver_stats(m_solver);
+        m_lits.clear();
+        for (int lit : assumptions)
+            add_literal(m_solver, m_lits, lit);
+        m_stats.number_of_solves++;
+
+        SatSolverResult result;
+        // the interruption of an expired deadline must not stop the next solves
+        m_solver.clearInterrupt();
+        const lbool ret = solve_within_budget(m_solver, m_lits, get_budget());
+        result.stats = get_solve_stats(m_solver, before, timer);
+        populate_result(m_solver, ret, result);
+        return result;
+    }
+
+    // the polarity is the sign of the literal to try, phase saving updates it during search
+    void set_phases(std::span<const int> literals) override {
+        for (int lit : literals) {
+            const int var = abs(lit) - 1;
+            if (var < m_solver.nVars())
+                m_solver.setPolarity(var, lit < 0);
+        }
+    }
+
+    SatBackendStats get_stats() const override {
+        SatBackendStats stats = m_stats;
+        stats.number_of_variables = static_cast<size_t>(m_solver.nVars());
+        return stats;
+    }
+};
+
+std::unique_ptr<SatBackend> create_glucose_backend(const SatBackendOptions& options) {
+    return std::make_unique<GlucoseBackend>(options);
+}
+
 } // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "domus/sat/sat.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "domus/sat/sat_backend.hpp"
+
+#include "backends.hpp"
+#include "glucose_solver.hpp"
+#include "solver_interrupter.hpp"
+#include "solver_timer.hpp"
+
+namespace domus::sat {
+
+using namespace Glucose;
+
+// conflicts of a worker between two exchanges of clauses
+constexpr uint64_t SHARING_INTERVAL = 1000;
+
+// learned clauses with a larger lbd are not shared
+constexpr unsigned MAX_SHARED_LBD = 2;
+
+using SharedClause = std::vector<int>; // literals encoded with toInt
+
+// clauses published by the workers, in order of publication
+class ClauseExchange {
+    std::mutex m_mutex;
+    std::vector<SharedClause> m_clauses;
+    std::vector<size_t> m_publishers;
+
+  public:
+    void publish(size_t worker, std::vector<SharedClause> clauses) {
+        std::lock_guard lock(m_mutex);
+        for (SharedClause& clause : clauses) {
+            m_clauses.push_back(std::move(clause));
+            m_publishers.push_back(worker);
+        }
+    }
+
+    // the clauses of the other workers published from position on, position is advanced
+    std::vector<SharedClause> collect(size_t worker, size_t& position) {
+        std::lock_guard lock(m_mutex);
+        std::vector<SharedClause> clauses;
+        for (; position < m_clauses.size(); ++position)
+            if (m_publishers[position] != worker)
+                clauses.push_back(m_clauses[position]);
+        return clauses;
+    }
+};
+
+// glucose-syrup shares unit and glue clauses at every conflict from inside the solver,
+// here they are read from the protected state of the solver between slices of conflicts
+class SharingSolver : public TunedSolver {
+    int m_exported_units = 0;
+    std::unordered_set<uint64_t> m_exported_clauses;
+    vec<Lit> m_lits;
+
+    static uint64_t hash_clause(SharedClause& clause) {
+        std::ranges::sort(clause);
+        uint64_t hash = uint64_t{14695981039346656037u};
+        for (int lit : clause)
+            hash = (hash ^ static_cast<uint64_t>(lit)) * uint64_t{1099511628211u};
+        return hash;
+    }
+
+  public:
+    // the first worker keeps the default settings, the others are diversified by their
+    // random seed, random initial activities and a random first descent
+    SharingSolver(size_t worker, const SatBackendOptions& options) : TunedSolver(options) {
+        if (worker == 0)
+            return;
+        random_seed += static_cast<double>(worker) * 7919.0;
+        rnd_init_act = true;
+        randomizeFirstDescent = true;
+        random_var_freq = 0.005;
+    }
+
+    void add_clause(std::span<const int> clause) {
+        m_lits.clear();
+        for (int lit : clause)
+            add_literal(*this, m_lits, lit);
+        addClause_(m_lits);
+    }
+
+    // new units of the root level and glue clauses not exported yet,
+    // the solver is back at the root level after solveLimited; only the hashes of the glue
+    // clauses still in the learned clauses are kept, so they never outgrow the database
+    std::vector<SharedClause> export_clauses() {
+        std::vector<SharedClause> exported;
+        for (; m_exported_units < trail.size(); ++m_exported_units)
+            exported.push_back({toInt(trail[m_exported_units])});
+        std::unordered_set<uint64_t> glue_clauses;
+        for (int i = 0; i < learnts.size(); ++i) {
+            const Clause& c = ca[learnts[i]];
+            if (c.lbd() > MAX_SHARED_LBD)
+                continue;
+            SharedClause clause;
+            for (int j = 0; j < c.size(); ++j)
+                clause.push_back(toInt(c[j]));
+            const uint64_t hash = hash_clause(clause);
+            glue_clauses.insert(hash);
+            if (!m_exported_clauses.contains(hash))
+                exported.push_back(std::move(clause));
+        }
+        m_exported_clauses = std::move(glue_clauses);
+        return exported;
+    }
+
+    // false if the formula is unsatisfiable, the imported clauses are implied by the
+    // clauses of the formula (not by the assumptions) and so they are kept for later solves
+    bool import_clauses(const std::vector<SharedClause>& imported) {
+        for (const SharedClause& clause : imported) {
+            m_lits.clear();
+            for (int lit : clause)
+                m_lits.push(toLit(lit));
+            if (!addClause_(m_lits))
+                return false;
+        }
+        // the units found by the other workers are not sent back
+        m_exported_units = trail.size();
+        return true;
+    }
+};
+
+// the first worker to finish stops the others
+struct ParallelSolve {
+    ClauseExchange exchange;
+    std::atomic<bool> is_stopped = false;
+    std::mutex mutex;
+    std::optional<size_t> winner;
+};
+
+// the budget holds for each worker, l_Undef if another worker finished first
+// or the budget ran out
+lbool run_worker(
+    SharingSolver& S,
+    size_t worker,
+    const vec<Lit>& assumptions,
+    const SatSolverBudget& budget,
+    ParallelSolve& solve
+) {
+    const uint64_t first_conflict = S.conflicts;
+    const uint64_t first_propagation = S.propagations;
+    size_t position = 0;
+    while (!solve.is_stopped) {
+        S.budgetOff();
+        uint64_t interval = SHARING_INTERVAL;
+        if (budget.conflicts.has_value()) {
+            const uint64_t used = S.conflicts - first_conflict;
+            if (used >= *budget.conflicts)
+                return l_Undef;
+            interval = std::min(interval, *budget.conflicts - used);
+        }
+        S.setConfBudget(static_cast<int64_t>(interval));
+        if (budget.propagations.has_value()) {
+            const uint64_t used = S.propagations - first_propagation;
+            if (used >= *budget.propagations)
+                return l_Undef;
+            S.setPropBudget(static_cast<int64_t>(*budget.propagations - used));
+        }
+        const lbool ret = S.solveLimited(assumptions);
+        if (ret != l_Undef)
+            return ret;
+        solve.exchange.publish(worker, S.export_clauses());
+        if (!S.import_clauses(solve.exchange.collect(worker, position))) {
+            // unsatisfiable without assumptions
+            S.conflict.clear();
+            return l_False;
+        }
+    }
+    return l_Undef;
+}
+
+SatSolverResult solve_in_parallel(
+    std::span<const std::unique_ptr<SharingSolver>> solvers,
+    const vec<Lit>& assumptions,
+    const SatSolverBudget& budget
+) {
+    const SolverTimer timer;
+    std::vector<SatSolverStats> before;
+    for (const std::unique_ptr<SharingSolver>& S : solvers) {
+        // the interruption of a previous solve must not stop this one
+        S->clearInterrupt();
+        before.push_back(get_solver_stats(*S));
+    }
+    ParallelSolve solve;
+    std::vector<lbool> results(solvers.size(), l_Undef);
+    auto stop_all = [&]() {
+        solve.is_stopped = true;
+        for (const std::unique_ptr<SharingSolver>& S : solvers)
+            S->interrupt();
+    };
+    {
+        const DeadlineWatchdog watchdog(budget, stop_all);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < solvers.size(); ++i)
+            threads.emplace_back([&, i]() {
+                results[i] = run_worker(*solvers[i], i, assumptions, budget, solve);
+                if (results[i] == l_Undef)
+                    return;
+                {
+                    std::lock_guard lock(solve.mutex);
+                    if (solve.winner.has_value())
+                        return;
+                    solve.winner = i;
+                }
+                stop_all();
+            });
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+    SatSolverResult result;
+    for (size_t i = 0; i < solvers.size(); ++i)
+        result.stats += get_solve_stats(*solvers[i], before[i], timer);
+    result.stats.number_of_solves = 1;
+    result.stats.wall_time_ms = timer.get_elapsed_ms();
+    if (!solve.winner.has_value()) {
+        result.result = SatSolverResultType::UNKNOWN;
+        return result;
+    }
+    populate_result(*solvers[*solve.winner], results[*solve.winner], result);
+    return result;
+}
+
+size_t get_number_of_workers(size_t number_of_threads) {
+    if (number_of_threads > 0)
+        return number_of_threads;
+    return std::max(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+}
+
+// every worker has all the clauses, the assumptions are added to the variables of all
+class GlucoseParallelBackend final : public SatBackend {
+    std::vector<std::unique_ptr<SharingSolver>> m_solvers;
+    vec<Lit> m_lits;
+    SatBackendStats m_stats;
+
+  public:
+    GlucoseParallelBackend(size_t number_of_threads, const SatBackendOptions& options) {
+        for (size_t i = 0; i < get_number_of_workers(number_of_threads); ++i)
+            m_solvers.push_back(std::make_unique<SharingSolver>(i, options));
+    }
+
+    void add_clause(std::span<const int> clause) override {
+        for (const std::unique_ptr<SharingSolver>& S : m_solvers)
+            S->add_clause(clause);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        for (const std::unique_ptr<SharingSolver>& S : m_solvers)
+            while (static_cast<size_t>(S->nVars()) < number_of_variables)
+                S->newVar();
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        m_lits.clear();
+        for (int lit : assumptions)
+            add_literal(*m_solvers[0], m_lits, lit);
+        reserve_variables(static_cast<size_t>(m_solvers[0]->nVars()));
+        m_stats.number_of_solves++;
+        return solve_in_parallel(m_solvers, m_lits, get_budget());
+    }
+
+    void set_phases(std::span<const int> literals) override {
+        for (const std::unique_ptr<SharingSolver>& S : m_solvers)
+            for (int lit : literals) {
+                const int var = std::abs(lit) - 1;
+                if (var < S->nVars())
+                    S->setPolarity(var, lit < 0);
+            }
+    }
+
+    SatBackendStats get_stats() const override {
+        SatBackendStats stats = m_stats;
+        stats.number_of_variables = static_cast<size_t>(m_solvers[0]->nVars());
+        return stats;
+    }
+};
+
+std::unique_ptr<SatBackend>
+create_glucose_parallel_backend(size_t number_of_threads, const SatBackendOptions& options) {
+    return std::make_unique<GlucoseParallelBackend>(number_of_threads, options);
+}
+
+} // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "domus/sat/sat.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+#include "solver_timer.hpp"
+
+#include "glucose/src/Solver.h"
+#include "glucose/src/SolverTypes.h"
+#include "glucose/src/Vec.h"
+
+namespace domus::sat {
+
+// a solver with the restart settings of the options (the unset ones keep the glucose defaults)
+class TunedSolver : public Glucose::Solver {
+  public:
+    explicit TunedSolver(const SatBackendOptions& options) {
+        verbosity = 0;
+        showModel = false;
+        if (options.glucose_k.has_value())
+            K = *options.glucose_k;
+        if (options.glucose_r.has_value())
+            R = *options.glucose_r;
+        // the queues are sized by the constructor of Solver
+        if (options.glucose_lbd_queue_size.has_value()) {
+            sizeLBDQueue = *options.glucose_lbd_queue_size;
+            lbdQueue.initSize(*options.glucose_lbd_queue_size);
+        }
+        if (options.glucose_trail_queue_size.has_value()) {
+            sizeTrailQueue = *options.glucose_trail_queue_size;
+            trailQueue.initSize(*options.glucose_trail_queue_size);
+        }
+    }
+};
+
+// helpers of glucose.cpp and glucose_parallel.cpp, shared by the multi-threaded solvers
+
+void add_literal(Glucose::Solver& S, Glucose::vec<Glucose::Lit>& lits, int lit);
+
+SatSolverStats get_solver_stats(const Glucose::Solver& S);
+
+SatSolverStats
+get_solve_stats(const Glucose::Solver& S, const SatSolverStats& before, const SolverTimer& timer);
+
+Glucose::lbool solve_within_budget(
+    Glucose::Solver& S, const Glucose::vec<Glucose::Lit>& assumptions, const SatSolverBudget& budget
+);
+
+// the model if ret is l_True, the failed assumptions if l_False, UNKNOWN otherwise
+void populate_result(const Glucose::Solver& S, Glucose::lbool ret, SatSolverResult& result);
+
+// one worker per hardware thread if number_of_threads is 0
+size_t get_number_of_workers(size_t number_of_threads);
+
+} // namespace domus::sat
\ No newline at end of file
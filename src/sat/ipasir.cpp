@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "domus/sat/sat.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+#include "../core/domus_debug.hpp"
+#include "backends.hpp"
+#include "ipasir.h"
+#include "solver_timer.hpp"
+
+namespace domus::sat {
+
+class IpasirBackend final : public SatBackend {
+    void* m_solver;
+    SatBackendStats m_stats;
+
+    void add_variable(int lit) {
+        m_stats.number_of_variables =
+            std::max(m_stats.number_of_variables, static_cast<size_t>(std::abs(lit)));
+    }
+
+  public:
+    IpasirBackend() : m_solver(ipasir_init()) {
+        DOMUS_ASSERT(m_solver != nullptr, "IpasirBackend: failed to initialize the solver");
+    }
+
+    ~IpasirBackend() override { ipasir_release(m_solver); }
+
+    IpasirBackend(const IpasirBackend&) = delete;
+    IpasirBackend& operator=(const IpasirBackend&) = delete;
+
+    void add_clause(std::span<const int> clause) override {
+        for (int lit : clause) {
+            DOMUS_ASSERT(lit != 0, "IpasirBackend: internal errors, found a 0 literal");
+            add_variable(lit);
+            ipasir_add(m_solver, lit);
+        }
+        ipasir_add(m_solver, 0);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        m_stats.number_of_variables = std::max(m_stats.number_of_variables, number_of_variables);
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        for (int lit : assumptions) {
+            add_variable(lit);
+            ipasir_assume(m_solver, lit);
+        }
+        m_stats.number_of_solves++;
+
+        const SolverTimer timer;
+        SatSolverResult result;
+        // ipasir has no limits, the deadline is polled by the terminate callback
+        const SatSolverBudget& budget = get_budget();
+        ipasir_set_terminate(m_solver, const_cast<SatSolverBudget*>(&budget), [](void* state) {
+            return static_cast<const SatSolverBudget*>(state)->is_expired() ? 1 : 0;
+        });
+        const int res = ipasir_solve(m_solver);
+        ipasir_set_terminate(m_solver, nullptr, nullptr);
+        // ipasir exposes no counters, only the time is known
+        result.stats.number_of_solves = 1;
+        result.stats.wall_time_ms = timer.get_elapsed_ms();
+        if (res == 0) {
+            result.result = SatSolverResultType::UNKNOWN;
+            return result;
+        }
+        DOMUS_ASSERT(res == 10 || res == 20, "IpasirBackend::solve: invalid solver result");
+        if (res == 10) {
+            result.result = SatSolverResultType::SAT;
+            for (int var = 1; var <= static_cast<int>(m_stats.number_of_variables); ++var)
+                result.numbers.push_back(ipasir_val(m_solver, var) > 0 ? var : -var);
+            return result;
+        }
+        result.result = SatSolverResultType::UNSAT;
+        for (int lit : assumptions)
+            if (ipasir_failed(m_solver, lit))
+                result.failed_assumptions.push_back(lit);
+        return result;
+    }
+
+    // ipasir has no way to set the phase of a variable
+    void set_phases(std::span<const int>) override {}
+
+    SatBackendStats get_stats() const override { return m_stats; }
+};
+
+std::unique_ptr<SatBackend> create_ipasir_backend() { return std::make_unique<IpasirBackend>(); }
+
+} // namespace domus::sat
\ No newline at end of file
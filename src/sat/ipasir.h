@@ -0,0 +1,24 @@
+#pragma once
+
+// the standard IPASIR interface, implemented by the linked solver library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* ipasir_signature();
+void* ipasir_init();
+void ipasir_release(void* solver);
+void ipasir_add(void* solver, int lit_or_zero);
+void ipasir_assume(void* solver, int lit);
+int ipasir_solve(void* solver);
+int ipasir_val(void* solver, int lit);
+int ipasir_failed(void* solver, int lit);
+void ipasir_set_terminate(void* solver, void* data, int (*terminate)(void* data));
+void ipasir_set_learn(
+    void* solver, void* data, int max_length, void (*learn)(void* data, int* clause)
+);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -1,8 +1,16 @@
 #include "domus/sat/sat.hpp"
 
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <expected>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
 #include <stdio.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 extern "C" {
@@ -11,16 +19,21 @@ extern "C" {
 #include "kissat/src/proof.h"
 }
 
-#include "../core/memory_file.hpp"
 #include "domus/sat/cnf.hpp"
 
+#include "backends.hpp"
+#include "kissat_internals.h"
+#include "solver_interrupter.hpp"
+#include "solver_timer.hpp"
+#include "unit_clauses_proof.hpp"
+
 namespace domus::sat {
 using namespace cnf;
 
 class KissatSolver {
   private:
     kissat* m_solver = nullptr;
-    std::string m_proof{};
+    std::vector<int> m_proof_unit_clauses{};
     KissatSolver(kissat* solver) : m_solver(solver) {}
 
   public:
@@ -36,42 +49,100 @@ class KissatSolver {
             kissat_release(m_solver);
     }
 
-    void add_clause(const std::vector<int>& clause) {
+    KissatSolver(KissatSolver&& other) noexcept
+        : m_solver(std::exchange(other.m_solver, nullptr)),
+          m_proof_unit_clauses(std::move(other.m_proof_unit_clauses)) {}
+    KissatSolver& operator=(KissatSolver&& other) noexcept {
+        std::swap(m_solver, other.m_solver);
+        std::swap(m_proof_unit_clauses, other.m_proof_unit_clauses);
+        return *this;
+    }
+
+    KissatSolver(const KissatSolver&) = delete;
+    KissatSolver& operator=(const KissatSolver&) = delete;
+
+    void add_clause(std::span<const int> clause) {
         for (int lit : clause)
             kissat_add(m_solver, lit);
         kissat_add(m_solver, 0); // terminate clause
     }
 
-    std::expected<bool, std::string> solve() {
+    void reserve_variables(size_t number_of_variables) {
+        kissat_reserve(m_solver, static_cast<int>(number_of_variables));
+    }
+
+    void set_phases(std::span<const int> literals) {
+        kissat_set_phases(m_solver, literals.data(), literals.size());
+    }
+
+    bool set_configuration(const std::string& configuration) {
+        return kissat_set_configuration(m_solver, configuration.c_str()) != 0;
+    }
+
+    void terminate() { kissat_terminate(m_solver); }
+
+    // std::nullopt if the solver was terminated or ran out of budget,
+    // kissat has no propagation limit
+    std::optional<bool> solve_without_proof(const SatSolverBudget& budget = {}) {
+        if (budget.conflicts.has_value())
+            kissat_set_conflict_limit(
+                m_solver,
+                static_cast<unsigned>(
+                    std::min<uint64_t>(*budget.conflicts, std::numeric_limits<unsigned>::max())
+                )
+            );
+        const DeadlineWatchdog watchdog(budget, [this]() { terminate(); });
+        int res = kissat_solve(m_solver);
+        if (res == 10)
+            return true;
+        if (res == 20)
+            return false;
+        return std::nullopt;
+    }
+
+    std::optional<bool> solve(const SatSolverBudget& budget = {}) {
         file proof_file;
-        MemoryFile memory_file = MemoryFile::create().value();
-        proof_file.file = memory_file.get_file();
+        UnitClausesProof unit_clauses_proof = UnitClausesProof::create(true).value();
+        proof_file.file = unit_clauses_proof.get_file();
         proof_file.close = true;
         proof_file.reading = false;
         proof_file.compressed = false;
         proof_file.path = NULL;
         proof_file.bytes = 0;
-        kissat_init_proof(m_solver, &proof_file, false);
-        int res = kissat_solve(m_solver);
+        kissat_init_proof(m_solver, &proof_file, true);
+        const std::optional<bool> is_sat = solve_without_proof(budget);
         kissat_release_proof(m_solver);
-        m_proof = memory_file.get_buffer();
-        if (res == 10)
-            return true;
-        if (res == 20)
-            return false;
-        return std::unexpected("Kissat solver returned UNKNOWN");
+        m_proof_unit_clauses = unit_clauses_proof.get_unit_clauses();
+        return is_sat;
     }
 
     bool value(int lit) const { return kissat_value(m_solver, lit) > 0; }
 
-    const std::string& get_proof() const { return m_proof; }
+    const std::vector<int>& get_proof_unit_clauses() const { return m_proof_unit_clauses; }
+
+    SatSolverStats get_stats() const {
+        const kissat_counters counters = kissat_get_counters(m_solver);
+        SatSolverStats stats;
+        stats.number_of_solves = 1;
+        stats.conflicts = counters.conflicts;
+        stats.decisions = counters.decisions;
+        stats.propagations = counters.propagations;
+        stats.restarts = counters.restarts;
+        stats.learned_clauses = counters.learned_clauses;
+        stats.peak_memory_mb = counters.peak_memory_mb;
+        return stats;
+    }
 };
 
-SatSolverResult create_result(bool is_sat, KissatSolver& solver, const Cnf& cnf) {
+SatSolverResult create_result(
+    std::optional<bool> is_sat, KissatSolver& solver, size_t number_of_variables
+) {
     SatSolverResult result;
-    if (is_sat) {
+    if (!is_sat.has_value())
+        result.result = SatSolverResultType::UNKNOWN;
+    else if (*is_sat) {
         result.result = SatSolverResultType::SAT;
-        for (int var = 1; var <= static_cast<int>(cnf.get_number_of_variables()); ++var) {
+        for (int var = 1; var <= static_cast<int>(number_of_variables); ++var) {
             if (solver.value(var))
                 result.numbers.push_back(var);
             else
@@ -79,26 +150,204 @@ SatSolverResult create_result(bool is_sat, KissatSolver& solver, const Cnf& cnf)
         }
     } else {
         result.result = SatSolverResultType::UNSAT;
-        const std::string proof_str = solver.get_proof();
-        std::istringstream iss(proof_str);
-        std::string line;
-        while (std::getline(iss, line))
-            result.proof_lines.push_back(line);
+        result.proof_unit_clauses = solver.get_proof_unit_clauses();
     }
+    result.stats = solver.get_stats();
     return result;
 }
 
-std::expected<SatSolverResult, std::string> launch_kissat(const Cnf& cnf) {
+void add_clauses(KissatSolver& solver, const Cnf& cnf) {
+    solver.reserve_variables(cnf.get_number_of_variables());
+    for (std::span<const int> clause : cnf.get_clauses())
+        solver.add_clause(clause);
+}
+
+std::expected<SatSolverResult, std::string>
+launch_kissat(const Cnf& cnf, const SatSolverBudget& budget) {
+    const SolverTimer timer;
+    return KissatSolver::create().and_then(
+        [&](KissatSolver solver) -> std::expected<SatSolverResult, std::string> {
+            add_clauses(solver, cnf);
+            const std::optional<bool> is_sat = solver.solve(budget);
+            SatSolverResult result = create_result(is_sat, solver, cnf.get_number_of_variables());
+            result.stats.wall_time_ms = timer.get_elapsed_ms();
+            return result;
+        }
+    );
+}
+
+std::expected<std::optional<SatSolverResult>, std::string> launch_kissat(
+    const Cnf& cnf,
+    const std::string& configuration,
+    const SatSolverBudget& budget,
+    SolverInterrupter& interrupter
+) {
+    const SolverTimer timer;
     return KissatSolver::create().and_then(
-        [&cnf](KissatSolver solver) -> std::expected<SatSolverResult, std::string> {
-            for (const CnfRow& row : cnf.get_rows())
-                if (row.type == CnfRowType::CLAUSE)
-                    solver.add_clause(row.clause);
-            return solver.solve().transform([&solver, &cnf](bool is_sat) -> SatSolverResult {
-                return create_result(is_sat, solver, cnf);
-            });
+        [&](KissatSolver solver) -> std::expected<std::optional<SatSolverResult>, std::string> {
+            if (!solver.set_configuration(configuration))
+                return std::unexpected("Unknown Kissat configuration: " + configuration);
+            add_clauses(solver, cnf);
+            interrupter.attach([&solver]() { solver.terminate(); });
+            const std::optional<bool> is_sat = solver.solve(budget);
+            interrupter.detach();
+            if (!is_sat.has_value())
+                return std::nullopt;
+            SatSolverResult result = create_result(is_sat, solver, cnf.get_number_of_variables());
+            result.stats.wall_time_ms = timer.get_elapsed_ms();
+            return result;
         }
     );
 }
 
+std::expected<std::optional<SatSolverResult>, std::string> launch_kissat(
+    const Cnf& cnf,
+    const std::vector<int>& assumptions,
+    std::span<const int> phases,
+    const std::string& configuration,
+    const SatSolverBudget& budget,
+    SolverInterrupter& interrupter
+) {
+    const SolverTimer timer;
+    return KissatSolver::create().and_then(
+        [&](KissatSolver solver) -> std::expected<std::optional<SatSolverResult>, std::string> {
+            if (!solver.set_configuration(configuration))
+                return std::unexpected("Unknown Kissat configuration: " + configuration);
+            add_clauses(solver, cnf);
+            size_t number_of_variables = cnf.get_number_of_variables();
+            for (const int& lit : assumptions) {
+                solver.add_clause(std::span<const int>(&lit, 1));
+                number_of_variables =
+                    std::max(number_of_variables, static_cast<size_t>(std::abs(lit)));
+            }
+            // the variables must already be in the clauses
+            solver.set_phases(phases);
+            interrupter.attach([&solver]() { solver.terminate(); });
+            const std::optional<bool> is_sat = solver.solve_without_proof(budget);
+            interrupter.detach();
+            if (!is_sat.has_value())
+                return std::nullopt;
+            SatSolverResult result = create_result(is_sat, solver, number_of_variables);
+            result.stats.wall_time_ms = timer.get_elapsed_ms();
+            return result;
+        }
+    );
+}
+
+// the extra solves of shrink_core, each one builds the solver again from scratch
+constexpr size_t MAX_CORE_SHRINKING_SOLVES = 16;
+
+// kissat is not incremental: every call of solve starts from scratch,
+// with the assumptions added as unit clauses
+class KissatBackend final : public SatBackend {
+    std::string m_configuration;
+    cnf::Cnf m_clauses;
+    std::vector<int> m_phases;
+    SatBackendStats m_stats;
+
+    KissatSolver build_solver(const std::vector<int>& assumptions) const {
+        KissatSolver solver = KissatSolver::create().value();
+        // checked by create_kissat_backend
+        solver.set_configuration(m_configuration);
+        solver.reserve_variables(m_stats.number_of_variables);
+        for (std::span<const int> clause : m_clauses.get_clauses())
+            solver.add_clause(clause);
+        for (const int& lit : assumptions)
+            solver.add_clause(std::span<const int>(&lit, 1));
+        // the variables must already be in the clauses
+        solver.set_phases(m_phases);
+        return solver;
+    }
+
+    // a solve out of budget counts as SAT, so the core stays valid
+    bool is_unsat(
+        const std::vector<int>& assumptions, const SatSolverBudget& budget, SatSolverStats& stats
+    ) const {
+        KissatSolver solver = build_solver(assumptions);
+        const std::optional<bool> is_sat = solver.solve_without_proof(budget);
+        stats += solver.get_stats();
+        return is_sat == false;
+    }
+
+    // kissat has no failed assumptions, the core is shrunk by removing chunks of
+    // assumptions (halving their size) as long as the formula stays UNSAT; at most
+    // MAX_CORE_SHRINKING_SOLVES extra solves, which share the conflicts and the deadline
+    // left by the solve that found the core (whose counters are in stats)
+    // the counters of the extra solves are added to stats
+    std::vector<int> shrink_core(std::vector<int> core, SatSolverStats& stats) const {
+        SatSolverBudget budget = get_budget();
+        size_t number_of_solves = 0;
+        for (size_t chunk = core.size() / 2; chunk > 0; chunk /= 2) {
+            size_t i = 0;
+            while (i < core.size()) {
+                if (number_of_solves++ == MAX_CORE_SHRINKING_SOLVES || budget.is_expired())
+                    return core;
+                if (get_budget().conflicts.has_value()) {
+                    if (stats.conflicts >= *get_budget().conflicts)
+                        return core;
+                    budget.conflicts = *get_budget().conflicts - stats.conflicts;
+                }
+                const size_t end = std::min(i + chunk, core.size());
+                std::vector<int> candidate(core.begin(), core.begin() + static_cast<long>(i));
+                candidate.insert(
+                    candidate.end(), core.begin() + static_cast<long>(end), core.end()
+                );
+                if (is_unsat(candidate, budget, stats))
+                    core = std::move(candidate);
+                else
+                    i = end;
+            }
+        }
+        return core;
+    }
+
+  public:
+    explicit KissatBackend(const SatBackendOptions& options)
+        : m_configuration(options.kissat_configuration) {}
+
+    void add_clause(std::span<const int> clause) override {
+        for (int lit : clause)
+            m_stats.number_of_variables =
+                std::max(m_stats.number_of_variables, static_cast<size_t>(std::abs(lit)));
+        m_clauses.add_clause(clause);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        m_stats.number_of_variables = std::max(m_stats.number_of_variables, number_of_variables);
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        const SolverTimer timer;
+        m_stats.number_of_solves++;
+        KissatSolver solver = build_solver(assumptions);
+        size_t number_of_variables = m_stats.number_of_variables;
+        for (int lit : assumptions)
+            number_of_variables = std::max(number_of_variables, static_cast<size_t>(std::abs(lit)));
+        const std::optional<bool> is_sat = solver.solve_without_proof(get_budget());
+        SatSolverResult result = create_result(is_sat, solver, number_of_variables);
+        if (is_sat == false)
+            result.failed_assumptions = shrink_core(assumptions, result.stats);
+        result.stats.wall_time_ms = timer.get_elapsed_ms();
+        return result;
+    }
+
+    void set_phases(std::span<const int> literals) override {
+        m_phases.assign(literals.begin(), literals.end());
+    }
+
+    SatBackendStats get_stats() const override { return m_stats; }
+};
+
+std::expected<std::unique_ptr<SatBackend>, std::string>
+create_kissat_backend(const SatBackendOptions& options) {
+    if (!is_kissat_configuration(options.kissat_configuration))
+        return std::unexpected("Unknown Kissat configuration: " + options.kissat_configuration);
+    return std::make_unique<KissatBackend>(options);
+}
+
+bool is_kissat_configuration(const std::string& configuration) {
+    return kissat_has_configuration(configuration.c_str()) != 0;
+}
+
 } // namespace domus::sat
\ No newline at end of file
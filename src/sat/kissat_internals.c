@@ -0,0 +1,33 @@
+#include "kissat_internals.h"
+
+#include <sys/resource.h>
+
+#include "kissat/src/internal.h"
+
+struct kissat_counters kissat_get_counters(struct kissat* solver) {
+    const statistics* stats = &solver->statistics;
+    struct kissat_counters counters;
+    counters.conflicts = stats->conflicts;
+    counters.decisions = stats->decisions;
+    counters.propagations = stats->propagations;
+    counters.restarts = stats->restarts;
+    counters.learned_clauses = stats->clauses_learned;
+    struct rusage usage;
+    // ru_maxrss is in kilobytes
+    counters.peak_memory_mb =
+        getrusage(RUSAGE_SELF, &usage) == 0 ? (double)usage.ru_maxrss / 1024.0 : 0.0;
+    return counters;
+}
+
+void kissat_set_phases(struct kissat* solver, const int* literals, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        const int literal = literals[i];
+        const unsigned variable = (unsigned)ABS(literal);
+        if (variable >= SIZE_STACK(solver->import))
+            continue;
+        const import* imported = &PEEK_STACK(solver->import, variable);
+        if (!imported->imported || imported->eliminated)
+            continue;
+        solver->phases.saved[IDX(imported->lit)] = literal < 0 ? -1 : 1;
+    }
+}
\ No newline at end of file
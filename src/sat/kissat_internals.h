@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct kissat;
+
+struct kissat_counters {
+    uint64_t conflicts;
+    uint64_t decisions;
+    uint64_t propagations;
+    uint64_t restarts;
+    uint64_t learned_clauses;
+    // peak resident memory of the process: kissat only measures it when not built QUIET
+    double peak_memory_mb;
+};
+
+// the statistics and the phases of the solver are only reachable through its internal
+// headers: the file is part of the kissat target, compiled with the same options
+
+struct kissat_counters kissat_get_counters(struct kissat* solver);
+
+// the literals become the saved phases of their variables, as if they came from a
+// previous search; variables that do not appear in a clause are skipped
+void kissat_set_phases(struct kissat* solver, const int* literals, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
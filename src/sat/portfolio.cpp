@@ -0,0 +1,180 @@
+#include "domus/sat/sat.hpp"
+
+#include <deque>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "domus/sat/cnf.hpp"
+
+#include "backends.hpp"
+#include "glucose_solver.hpp"
+#include "solver_interrupter.hpp"
+#include "solver_timer.hpp"
+
+namespace domus::sat {
+using namespace cnf;
+using namespace Glucose;
+
+std::expected<SatSolverResult, std::string> launch_portfolio(
+    const Cnf& cnf,
+    const std::vector<std::string>& kissat_configurations,
+    const SatSolverBudget& budget
+) {
+    std::deque<SolverInterrupter> interrupters(kissat_configurations.size() + 1);
+    std::mutex mutex;
+    std::optional<SatSolverResult> winner;
+    std::optional<std::string> error;
+    // the first solver to finish stops all the others
+    auto finish = [&](std::optional<SatSolverResult> result) {
+        if (!result.has_value())
+            return;
+        {
+            std::lock_guard lock(mutex);
+            if (winner.has_value())
+                return;
+            winner = std::move(result);
+        }
+        for (SolverInterrupter& interrupter : interrupters)
+            interrupter.interrupt();
+    };
+    std::vector<std::thread> threads;
+    threads.emplace_back([&]() { finish(launch_glucose(cnf, budget, interrupters[0])); });
+    for (size_t i = 0; i < kissat_configurations.size(); ++i)
+        threads.emplace_back([&, i]() {
+            auto result = launch_kissat(cnf, kissat_configurations[i], budget, interrupters[i + 1]);
+            if (result.has_value()) {
+                finish(std::move(*result));
+                return;
+            }
+            std::lock_guard lock(mutex);
+            error = std::move(result.error());
+        });
+    for (std::thread& thread : threads)
+        thread.join();
+    if (winner.has_value())
+        return std::move(*winner);
+    if (error.has_value())
+        return std::unexpected(std::move(*error));
+    // no solver was interrupted by a winner, so all of them ran out of budget
+    SatSolverResult result;
+    result.result = SatSolverResultType::UNKNOWN;
+    return result;
+}
+
+// an incremental glucose races a kissat that solves from scratch with the assumptions as unit
+// clauses; kissat has no failed assumptions, so its UNSAT answers do not stop glucose, which
+// then finds the core (all the assumptions if glucose runs out of budget); a SAT answer
+// stops the other solver; the budget holds for each of them and they share the deadline
+class PortfolioBackend final : public SatBackend {
+    TunedSolver m_glucose;
+    vec<Lit> m_lits;
+    Cnf m_clauses;
+    std::string m_kissat_configuration;
+    std::vector<int> m_phases;
+    SatBackendStats m_stats;
+
+  public:
+    explicit PortfolioBackend(const SatBackendOptions& options)
+        : m_glucose(options), m_kissat_configuration(options.kissat_configuration) {}
+
+    void add_clause(std::span<const int> clause) override {
+        m_lits.clear();
+        for (int lit : clause)
+            add_literal(m_glucose, m_lits, lit);
+        m_glucose.addClause_(m_lits);
+        m_clauses.add_clause(clause);
+        m_stats.number_of_clauses++;
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        while (static_cast<size_t>(m_glucose.nVars()) < number_of_variables)
+            m_glucose.newVar();
+        m_clauses.reserve_variables(number_of_variables);
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        const SolverTimer timer;
+        const SatSolverStats before = get_solver_stats(m_glucose);
+        m_lits.clear();
+        for (int lit : assumptions)
+            add_literal(m_glucose, m_lits, lit);
+        m_stats.number_of_solves++;
+
+        SolverInterrupter glucose_interrupter;
+        SolverInterrupter kissat_interrupter;
+        std::optional<SatSolverResult> kissat_result;
+        std::thread kissat_thread([&]() {
+            auto result = launch_kissat(
+                m_clauses,
+                assumptions,
+                m_phases,
+                m_kissat_configuration,
+                get_budget(),
+                kissat_interrupter
+            );
+            // if kissat cannot run, glucose solves alone
+            if (!result.has_value() || !result->has_value())
+                return;
+            kissat_result = std::move(**result);
+            if (kissat_result->result == SatSolverResultType::SAT)
+                glucose_interrupter.interrupt();
+        });
+        // the interruption of an expired deadline must not stop the next solves
+        m_glucose.clearInterrupt();
+        glucose_interrupter.attach([this]() { m_glucose.interrupt(); });
+        const lbool ret = solve_within_budget(m_glucose, m_lits, get_budget());
+        glucose_interrupter.detach();
+        if (ret != l_Undef)
+            kissat_interrupter.interrupt();
+        kissat_thread.join();
+
+        SatSolverResult result;
+        result.stats = get_solve_stats(m_glucose, before, timer);
+        if (ret == l_Undef && kissat_result.has_value()) {
+            result.result = kissat_result->result;
+            result.numbers = std::move(kissat_result->numbers);
+            if (result.result == SatSolverResultType::UNSAT)
+                result.failed_assumptions = assumptions;
+        } else
+            populate_result(m_glucose, ret, result);
+        if (kissat_result.has_value()) {
+            const double wall_time_ms = result.stats.wall_time_ms;
+            result.stats += kissat_result->stats;
+            result.stats.number_of_solves = 1;
+            result.stats.wall_time_ms = wall_time_ms;
+        }
+        return result;
+    }
+
+    // glucose takes the polarities, kissat the phases of its next solves
+    void set_phases(std::span<const int> literals) override {
+        for (int lit : literals) {
+            const int var = abs(lit) - 1;
+            if (var < m_glucose.nVars())
+                m_glucose.setPolarity(var, lit < 0);
+        }
+        m_phases.assign(literals.begin(), literals.end());
+    }
+
+    SatBackendStats get_stats() const override {
+        SatBackendStats stats = m_stats;
+        stats.number_of_variables = static_cast<size_t>(m_glucose.nVars());
+        return stats;
+    }
+};
+
+std::expected<std::unique_ptr<SatBackend>, std::string>
+create_portfolio_backend(const SatBackendOptions& options) {
+    if (!is_kissat_configuration(options.kissat_configuration))
+        return std::unexpected("Unknown Kissat configuration: " + options.kissat_configuration);
+    return std::make_unique<PortfolioBackend>(options);
+}
+
+} // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include "domus/sat/sat_backend.hpp"
+
+#include <format>
+#include <utility>
+
+#include "domus/core/config.hpp"
+
+#include "../core/domus_debug.hpp"
+#include "backends.hpp"
+
+namespace domus::sat {
+
+std::string sat_backend_type_to_string(const SatBackendType type) {
+    switch (type) {
+    case SatBackendType::GLUCOSE:
+        return "glucose";
+    case SatBackendType::GLUCOSE_PARALLEL:
+        return "glucose-parallel";
+    case SatBackendType::KISSAT:
+        return "kissat";
+    case SatBackendType::PORTFOLIO:
+        return "portfolio";
+    case SatBackendType::CUBE_AND_CONQUER:
+        return "cube-and-conquer";
+    case SatBackendType::TWO_SAT:
+        return "2-sat";
+    case SatBackendType::IPASIR:
+        return "ipasir";
+    default:
+        DOMUS_ASSERT(false, "sat_backend_type_to_string: invalid type");
+        return "Invalid type";
+    }
+}
+
+std::expected<SatBackendType, std::string> string_to_sat_backend_type(const std::string& type) {
+    if (type == "glucose")
+        return SatBackendType::GLUCOSE;
+    if (type == "glucose-parallel")
+        return SatBackendType::GLUCOSE_PARALLEL;
+    if (type == "kissat")
+        return SatBackendType::KISSAT;
+    if (type == "portfolio")
+        return SatBackendType::PORTFOLIO;
+    if (type == "cube-and-conquer")
+        return SatBackendType::CUBE_AND_CONQUER;
+    if (type == "2-sat")
+        return SatBackendType::TWO_SAT;
+    if (type == "ipasir") {
+#ifdef DOMUS_WITH_IPASIR
+        return SatBackendType::IPASIR;
+#else
+        return std::unexpected("SAT backend ipasir requires building with DOMUS_WITH_IPASIR");
+#endif
+    }
+    return std::unexpected("Unknown SAT backend: " + type);
+}
+
+std::expected<SatBackendType, std::string>
+get_sat_backend_type(const Config& config, const std::string& prefix) {
+    return string_to_sat_backend_type(config.get_or(prefix + "sat_backend", "glucose"));
+}
+
+std::expected<SatBackendOptions, std::string>
+get_sat_backend_options(const Config& config, const std::string& prefix) {
+    SatBackendOptions options;
+    auto k = config.get_number<double>(prefix + "glucose_k");
+    if (!k)
+        return std::unexpected(k.error());
+    options.glucose_k = *k;
+    auto r = config.get_number<double>(prefix + "glucose_r");
+    if (!r)
+        return std::unexpected(r.error());
+    options.glucose_r = *r;
+    auto lbd_queue_size = config.get_number<int>(prefix + "glucose_lbd_queue_size");
+    if (!lbd_queue_size)
+        return std::unexpected(lbd_queue_size.error());
+    options.glucose_lbd_queue_size = *lbd_queue_size;
+    auto trail_queue_size = config.get_number<int>(prefix + "glucose_trail_queue_size");
+    if (!trail_queue_size)
+        return std::unexpected(trail_queue_size.error());
+    options.glucose_trail_queue_size = *trail_queue_size;
+    for (const std::optional<int>& size :
+         {options.glucose_lbd_queue_size, options.glucose_trail_queue_size})
+        if (size.has_value() && *size <= 0)
+            return std::unexpected("Invalid glucose queue size: " + std::to_string(*size));
+    options.kissat_configuration = config.get_or(prefix + "kissat_configuration", "default");
+    if (!is_kissat_configuration(options.kissat_configuration))
+        return std::unexpected("Unknown Kissat configuration: " + options.kissat_configuration);
+    return options;
+}
+
+std::string
+sat_backend_options_to_config(const SatBackendOptions& options, const std::string& prefix) {
+    std::string config;
+    auto add = [&](const std::string& key, const auto& value) {
+        if (value.has_value())
+            config += std::format("{}{}={}\n", prefix, key, *value);
+    };
+    add("glucose_k", options.glucose_k);
+    add("glucose_r", options.glucose_r);
+    add("glucose_lbd_queue_size", options.glucose_lbd_queue_size);
+    add("glucose_trail_queue_size", options.glucose_trail_queue_size);
+    if (options.kissat_configuration != "default")
+        config += std::format("{}kissat_configuration={}\n", prefix, options.kissat_configuration);
+    return config;
+}
+
+std::string SatBackendOptions::to_string() const {
+    std::string result;
+    auto add = [&](const std::string& name, const auto& value) {
+        if (value.has_value())
+            result += std::format("{}{}={}", result.empty() ? "" : " ", name, *value);
+    };
+    add("K", glucose_k);
+    add("R", glucose_r);
+    add("lbd_queue", glucose_lbd_queue_size);
+    add("trail_queue", glucose_trail_queue_size);
+    if (kissat_configuration != "default")
+        result += std::format("{}kissat={}", result.empty() ? "" : " ", kissat_configuration);
+    return result;
+}
+
+std::expected<std::unique_ptr<SatBackend>, std::string> SatBackend::create(
+    const SatBackendType type, const size_t number_of_threads, const SatBackendOptions& options
+) {
+    switch (type) {
+    case SatBackendType::GLUCOSE:
+        return create_glucose_backend(options);
+    case SatBackendType::GLUCOSE_PARALLEL:
+        return create_glucose_parallel_backend(number_of_threads, options);
+    case SatBackendType::KISSAT:
+        return create_kissat_backend(options);
+    case SatBackendType::PORTFOLIO:
+        return create_portfolio_backend(options);
+    case SatBackendType::CUBE_AND_CONQUER:
+        return create_cube_and_conquer_backend(number_of_threads, options);
+    case SatBackendType::TWO_SAT:
+        return create_two_sat_backend();
+    case SatBackendType::IPASIR:
+#ifdef DOMUS_WITH_IPASIR
+        return create_ipasir_backend();
+#else
+        return std::unexpected(
+            std::string("SAT backend ipasir requires building with DOMUS_WITH_IPASIR")
+        );
+#endif
+    default:
+        return std::unexpected(std::string("Invalid SAT backend type"));
+    }
+}
+
+RecordingBackend::RecordingBackend(std::unique_ptr<SatBackend> backend)
+    : m_backend(std::move(backend)) {}
+
+void RecordingBackend::add_clause(std::span<const int> clause) {
+    m_formula.add_clause(clause);
+    m_backend->add_clause(clause);
+}
+
+void RecordingBackend::reserve_variables(size_t number_of_variables) {
+    m_formula.reserve_variables(number_of_variables);
+    m_backend->reserve_variables(number_of_variables);
+}
+
+SatSolverResult RecordingBackend::solve(const std::vector<int>& assumptions) {
+    m_last_assumptions = assumptions;
+    m_backend->set_budget(get_budget());
+    return m_backend->solve(assumptions);
+}
+
+void RecordingBackend::set_phases(std::span<const int> literals) {
+    m_backend->set_phases(literals);
+}
+
+void RecordingBackend::set_cubes(const std::vector<std::vector<int>>& cubes) {
+    m_backend->set_cubes(cubes);
+}
+
+SatBackendStats RecordingBackend::get_stats() const { return m_backend->get_stats(); }
+
+} // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "domus/sat/sat.hpp"
+
+namespace domus::sat {
+
+namespace cnf {
+class Cnf;
+}
+
+// lets another thread stop a running solver, the solver registers how to stop it
+// before solving; an interruption that comes before the registration is not lost
+class SolverInterrupter {
+    std::mutex m_mutex;
+    std::function<void()> m_stop;
+    bool m_is_interrupted = false;
+
+  public:
+    void attach(std::function<void()> stop) {
+        std::lock_guard lock(m_mutex);
+        m_stop = std::move(stop);
+        if (m_is_interrupted)
+            m_stop();
+    }
+
+    void detach() {
+        std::lock_guard lock(m_mutex);
+        m_stop = nullptr;
+    }
+
+    void interrupt() {
+        std::lock_guard lock(m_mutex);
+        m_is_interrupted = true;
+        if (m_stop)
+            m_stop();
+    }
+};
+
+// stops a solver when the deadline of its budget expires, from a separate thread that
+// is only started if there is a deadline; the solve must end before the destruction
+class DeadlineWatchdog {
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_is_done = false;
+    std::thread m_thread;
+
+  public:
+    DeadlineWatchdog(const SatSolverBudget& budget, std::function<void()> stop) {
+        if (!budget.deadline.has_value())
+            return;
+        m_thread = std::thread([this, deadline = *budget.deadline, stop = std::move(stop)]() {
+            std::unique_lock lock(m_mutex);
+            if (!m_condition.wait_until(lock, deadline, [this]() { return m_is_done; }))
+                stop();
+        });
+    }
+
+    ~DeadlineWatchdog() {
+        if (!m_thread.joinable())
+            return;
+        {
+            std::lock_guard lock(m_mutex);
+            m_is_done = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+    DeadlineWatchdog(const DeadlineWatchdog&) = delete;
+    DeadlineWatchdog& operator=(const DeadlineWatchdog&) = delete;
+};
+
+// as launch_glucose and launch_kissat, return std::nullopt if interrupted
+// or out of budget
+std::optional<SatSolverResult> launch_glucose(
+    const cnf::Cnf& cnf, const SatSolverBudget& budget, SolverInterrupter& interrupter
+);
+
+std::expected<std::optional<SatSolverResult>, std::string> launch_kissat(
+    const cnf::Cnf& cnf,
+    const std::string& configuration,
+    const SatSolverBudget& budget,
+    SolverInterrupter& interrupter
+);
+
+// kissat without proof, with the assumptions added as unit clauses and the phases as a hint
+std::expected<std::optional<SatSolverResult>, std::string> launch_kissat(
+    const cnf::Cnf& cnf,
+    const std::vector<int>& assumptions,
+    std::span<const int> phases,
+    const std::string& configuration,
+    const SatSolverBudget& budget,
+    SolverInterrupter& interrupter
+);
+
+} // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <chrono>
+
+namespace domus::sat {
+
+// wall time of a solve, started at construction
+class SolverTimer {
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+
+  public:
+    double get_elapsed_ms() const {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+};
+
+} // namespace domus::sat
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "domus/sat/sat.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "domus/sat/cnf.hpp"
+#include "domus/sat/sat_backend.hpp"
+
+#include "../core/domus_debug.hpp"
+#include "backends.hpp"
+#include "solver_timer.hpp"
+
+namespace domus::sat {
+
+// the literal of variable v is node 2 * (v - 1), its negation is the next node
+uint32_t literal_to_node(int literal) {
+    DOMUS_ASSERT(literal != 0, "literal_to_node: literal cannot be 0");
+    return 2 * static_cast<uint32_t>(std::abs(literal) - 1) + (literal < 0 ? 1u : 0u);
+}
+
+// implication graph of a 2-cnf in compressed sparse row format: the implications of node u
+// are targets[offsets[u]] ... targets[offsets[u + 1] - 1]
+struct ImplicationGraph {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+
+    uint32_t get_number_of_nodes() const { return static_cast<uint32_t>(offsets.size() - 1); }
+
+    // two passes over the clauses: the first counts the implications of each node,
+    // the second writes them; a unit clause (a) is the implication !a -> a
+    static ImplicationGraph
+    build(const cnf::Cnf& cnf, std::span<const int> unit_clauses, uint32_t number_of_nodes) {
+        ImplicationGraph graph;
+        graph.offsets.assign(number_of_nodes + 1, 0);
+        auto for_each_implication = [&](auto&& add) {
+            for (std::span<const int> clause : cnf.get_clauses()) {
+                DOMUS_ASSERT(
+                    clause.size() <= 2, "solve_2_sat: clause cannot have more than 2 literals"
+                );
+                if (clause.size() == 1)
+                    add(literal_to_node(-clause[0]), literal_to_node(clause[0]));
+                else if (clause.size() == 2) {
+                    add(literal_to_node(-clause[0]), literal_to_node(clause[1]));
+                    add(literal_to_node(-clause[1]), literal_to_node(clause[0]));
+                }
+            }
+            for (int literal : unit_clauses)
+                add(literal_to_node(-literal), literal_to_node(literal));
+        };
+        for_each_implication([&](uint32_t from, uint32_t) { graph.offsets[from + 1]++; });
+        for (uint32_t node = 0; node < number_of_nodes; ++node)
+            graph.offsets[node + 1] += graph.offsets[node];
+        graph.targets.resize(graph.offsets[number_of_nodes]);
+        std::vector<uint32_t> next(graph.offsets.begin(), graph.offsets.end() - 1);
+        for_each_implication([&](uint32_t from, uint32_t to) { graph.targets[next[from]++] = to; });
+        return graph;
+    }
+};
+
+// iterative tarjan, the components are numbered in reverse topological order
+std::vector<uint32_t> compute_components(const ImplicationGraph& graph) {
+    constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+    const uint32_t number_of_nodes = graph.get_number_of_nodes();
+    std::vector<uint32_t> index(number_of_nodes, UNVISITED);
+    std::vector<uint32_t> lowlink(number_of_nodes);
+    std::vector<uint32_t> component(number_of_nodes, UNVISITED);
+    std::vector<uint32_t> stack;
+    // nodes being visited, with the position of the next implication to follow
+    std::vector<uint32_t> call_stack;
+    std::vector<uint32_t> next_edge(number_of_nodes);
+    uint32_t next_index = 0;
+    uint32_t next_component = 0;
+    for (uint32_t root = 0; root < number_of_nodes; ++root) {
+        if (index[root] != UNVISITED)
+            continue;
+        auto visit = [&](uint32_t node) {
+            index[node] = lowlink[node] = next_index++;
+            next_edge[node] = graph.offsets[node];
+            stack.push_back(node);
+            call_stack.push_back(node);
+        };
+        visit(root);
+        while (!call_stack.empty()) {
+            const uint32_t node = call_stack.back();
+            if (next_edge[node] < graph.offsets[node + 1]) {
+                const uint32_t target = graph.targets[next_edge[node]++];
+                if (index[target] == UNVISITED)
+                    visit(target);
+                else if (component[target] == UNVISITED) // target is on the stack
+                    lowlink[node] = std::min(lowlink[node], index[target]);
+                continue;
+            }
+            call_stack.pop_back();
+            if (!call_stack.empty())
+                lowlink[call_stack.back()] = std::min(lowlink[call_stack.back()], lowlink[node]);
+            if (lowlink[node] != index[node])
+                continue;
+            uint32_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                component[member] = next_component;
+            } while (member != node);
+            next_component++;
+        }
+    }
+    return component;
+}
+
+SatSolverResult find_assignment(const cnf::Cnf& cnf, std::span<const int> unit_clauses) {
+    size_t num_vars = cnf.get_number_of_variables();
+    for (int literal : unit_clauses)
+        num_vars = std::max(num_vars, static_cast<size_t>(std::abs(literal)));
+    DOMUS_ASSERT(
+        2 * num_vars < std::numeric_limits<uint32_t>::max(),
+        "solve_2_sat: too many variables"
+    );
+    SatSolverResult result;
+    result.result = SatSolverResultType::UNKNOWN;
+    for (std::span<const int> clause : cnf.get_clauses())
+        if (clause.size() > 2)
+            return result;
+    result.result = SatSolverResultType::UNSAT;
+    for (std::span<const int> clause : cnf.get_clauses())
+        if (clause.empty())
+            return result;
+
+    const ImplicationGraph graph =
+        ImplicationGraph::build(cnf, unit_clauses, static_cast<uint32_t>(2 * num_vars));
+    const std::vector<uint32_t> component = compute_components(graph);
+
+    result.numbers.resize(num_vars);
+    for (uint32_t i = 0; i < num_vars; ++i) {
+        const uint32_t scc_pos = component[2 * i];
+        const uint32_t scc_neg = component[2 * i + 1];
+        // if x e !x are in the same SCC, there is no solution
+        if (scc_pos == scc_neg) {
+            result.numbers.clear();
+            return result;
+        }
+        // the component that comes later in topological order is true
+        const int variable = static_cast<int>(i + 1);
+        result.numbers[i] = scc_pos < scc_neg ? variable : -variable;
+    }
+    result.result = SatSolverResultType::SAT;
+    return result;
+}
+
+SatSolverResult solve_2_sat(const cnf::Cnf& cnf, std::span<const int> unit_clauses) {
+    const SolverTimer timer;
+    SatSolverResult result = find_assignment(cnf, unit_clauses);
+    result.stats.number_of_solves = 1;
+    result.stats.wall_time_ms = timer.get_elapsed_ms();
+    return result;
+}
+
+SatSolverResult solve_2_sat(const cnf::Cnf& cnf) { return solve_2_sat(cnf, {}); }
+
+// the whole set of assumptions is returned as core
+class TwoSatBackend final : public SatBackend {
+    cnf::Cnf m_cnf;
+    SatBackendStats m_stats;
+    // an empty clause or one with more than 2 literals, every solve is UNKNOWN from then on
+    bool m_has_unsupported_clause = false;
+
+  public:
+    void add_clause(std::span<const int> clause) override {
+        m_stats.number_of_clauses++;
+        if (clause.empty() || clause.size() > 2) {
+            m_has_unsupported_clause = true;
+            return;
+        }
+        m_cnf.add_clause(clause);
+    }
+
+    void reserve_variables(size_t number_of_variables) override {
+        m_cnf.reserve_variables(number_of_variables);
+    }
+
+    SatSolverResult solve(const std::vector<int>& assumptions) override {
+        m_stats.number_of_solves++;
+        // the solve is linear, only a deadline that already expired stops it
+        if (m_has_unsupported_clause || get_budget().is_expired()) {
+            SatSolverResult result;
+            result.result = SatSolverResultType::UNKNOWN;
+            return result;
+        }
+        // the assumptions are unit clauses of this solve only
+        SatSolverResult result = solve_2_sat(m_cnf, assumptions);
+        if (result.result == SatSolverResultType::UNSAT)
+            result.failed_assumptions = assumptions;
+        return result;
+    }
+
+    // the components decide the assignment, there is no search to guide
+    void set_phases(std::span<const int>) override {}
+
+    SatBackendStats get_stats() const override {
+        SatBackendStats stats = m_stats;
+        stats.number_of_variables = m_cnf.get_number_of_variables();
+        return stats;
+    }
+};
+
+std::unique_ptr<SatBackend> create_two_sat_backend() { return std::make_unique<TwoSatBackend>(); }
+
+} // namespace domus::sat
\ No newline at end of file
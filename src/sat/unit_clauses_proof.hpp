@@ -0,0 +1,133 @@
+#pragma once
+
+#include <expected>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// FILE* sink for DRAT proofs, in text or binary (vbyte) format: the proof is parsed while
+// it is written and only the most recently added unit clauses are kept, in a bounded ring
+class UnitClausesProof {
+    struct State {
+        bool binary = false;
+        std::vector<int> ring;
+        size_t ring_next = 0;
+        size_t ring_size = 0;
+        // clause being parsed
+        bool is_deletion = false;
+        bool is_header_expected = true;
+        size_t clause_size = 0;
+        int first_literal = 0;
+        // literal being parsed
+        unsigned value = 0;
+        unsigned shift = 0;
+        bool is_negative = false;
+        bool is_in_number = false;
+        FILE* file = nullptr;
+
+        ~State() {
+            if (file)
+                fclose(file);
+        }
+
+        void end_literal(int literal) {
+            if (literal != 0) {
+                if (clause_size++ == 0)
+                    first_literal = literal;
+                return;
+            }
+            if (clause_size == 1 && !is_deletion) {
+                ring[ring_next] = first_literal;
+                ring_next = (ring_next + 1) % ring.size();
+                if (ring_size < ring.size())
+                    ring_size++;
+            }
+            clause_size = 0;
+            is_deletion = false;
+            is_header_expected = true;
+        }
+
+        void read_binary(unsigned char ch) {
+            if (is_header_expected) {
+                is_deletion = ch == 'd';
+                is_header_expected = false;
+                return;
+            }
+            value |= static_cast<unsigned>(ch & 0x7f) << shift;
+            if (ch & 0x80) {
+                shift += 7;
+                return;
+            }
+            const int variable = static_cast<int>(value >> 1);
+            end_literal((value & 1) ? -variable : variable);
+            value = 0;
+            shift = 0;
+        }
+
+        void read_text(char ch) {
+            if (ch >= '0' && ch <= '9') {
+                value = value * 10 + static_cast<unsigned>(ch - '0');
+                is_in_number = true;
+            } else if (ch == '-')
+                is_negative = true;
+            else if (ch == 'd')
+                is_deletion = true;
+            else if (is_in_number) {
+                const int literal = static_cast<int>(value);
+                end_literal(is_negative ? -literal : literal);
+                value = 0;
+                is_negative = false;
+                is_in_number = false;
+            }
+        }
+    };
+    std::unique_ptr<State> state;
+    UnitClausesProof() : state(std::make_unique<State>()) {}
+
+    static ssize_t write(void* cookie, const char* buffer, size_t size) {
+        State* state = static_cast<State*>(cookie);
+        for (size_t i = 0; i < size; ++i) {
+            if (state->binary)
+                state->read_binary(static_cast<unsigned char>(buffer[i]));
+            else
+                state->read_text(buffer[i]);
+        }
+        return static_cast<ssize_t>(size);
+    }
+
+  public:
+    UnitClausesProof(UnitClausesProof&&) noexcept = default;
+    UnitClausesProof& operator=(UnitClausesProof&&) noexcept = default;
+
+    UnitClausesProof(const UnitClausesProof&) = delete;
+    UnitClausesProof& operator=(const UnitClausesProof&) = delete;
+
+    static std::expected<UnitClausesProof, std::string>
+    create(bool binary, size_t capacity = 256) {
+        UnitClausesProof sink;
+        sink.state->binary = binary;
+        sink.state->ring.resize(capacity == 0 ? 1 : capacity);
+        cookie_io_functions_t functions{};
+        functions.write = &UnitClausesProof::write;
+        sink.state->file = fopencookie(sink.state.get(), "w", functions);
+        if (!sink.state->file)
+            return std::unexpected("UnitClausesProof: Failed to fopencookie");
+        return sink;
+    }
+
+    FILE* get_file() { return state->file; }
+
+    // most recent first
+    std::vector<int> get_unit_clauses() {
+        if (state->file)
+            fflush(state->file);
+        std::vector<int> unit_clauses;
+        unit_clauses.reserve(state->ring_size);
+        const size_t capacity = state->ring.size();
+        for (size_t i = 1; i <= state->ring_size; ++i)
+            unit_clauses.push_back(state->ring[(state->ring_next + capacity - i) % capacity]);
+        return unit_clauses;
+    }
+};
\ No newline at end of file